@@ -0,0 +1,259 @@
+
+// Header files
+#include "uart.h"
+#include "arena.h"
+#include "irqvec.h"
+
+// The arena itself. It lives in its own .bss.arena input section so the
+// linker script can place it in a dedicated region; by default it is
+// collected with the rest of .bss and zeroed at boot.
+static unsigned char arena[ARENA_SIZE]
+    __attribute__((section(".bss.arena"), aligned(CACHE_LINE_SIZE)));
+
+// Bytes handed out so far, and allocations refused for lack of space
+static unsigned int arena_top;
+static unsigned int arena_failures;
+
+// Every pool that has been initialized, for pool_report_all()
+static struct pool *pools;
+
+
+// Mask IRQs around a pool list update and restore the previous state
+IRQ_CODE static unsigned long irq_save(void)
+{
+    unsigned long flags;
+
+    asm volatile("mrs %0, daif\n\tmsr daifset, #2" : "=r"(flags) :: "memory");
+    return flags;
+}
+
+IRQ_CODE static void irq_restore(unsigned long flags)
+{
+    asm volatile("msr daif, %0" :: "r"(flags) : "memory");
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       arena_alloc
+//
+//  Arguments:      size - number of bytes needed
+//                  align - required alignment, a power of 2 (0 means
+//                          CACHE_LINE_SIZE)
+//
+//  Returns:        pointer to the memory, or 0 if the arena is exhausted
+//
+//  Description:    Bump allocator over the static arena. Memory is never
+//                  given back, so this is meant for buffers set up once at
+//                  initialization. Using cache line alignment keeps buffers
+//                  shared with interrupt handlers or DMA from sharing a
+//                  line with unrelated data.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void *arena_alloc(unsigned int size, unsigned int align)
+{
+    unsigned int start;
+
+    if (align == 0)
+        align = CACHE_LINE_SIZE;
+
+    start = (arena_top + align - 1) & ~(align - 1);
+    if (start > ARENA_SIZE || size > ARENA_SIZE - start) {
+        arena_failures++;
+        return 0;
+    }
+
+    arena_top = start + size;
+
+    return &arena[start];
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       arena_used
+//
+//  Arguments:      none
+//
+//  Returns:        number of arena bytes allocated so far, including padding
+//
+//  Description:    Lets the arena size be tuned against real usage.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int arena_used(void)
+{
+    return arena_top;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       pool_init
+//
+//  Arguments:      p - the pool to set up
+//                  name - short name printed by pool_report_all()
+//                  block_size - size of each block in bytes
+//                  count - number of blocks
+//                  align - alignment of each block (0 means CACHE_LINE_SIZE)
+//
+//  Returns:        1 on success, 0 if the arena could not hold the pool
+//
+//  Description:    Carves count blocks out of the arena and threads them
+//                  onto the pool's free list. The block size is rounded up
+//                  to the alignment so that every block is aligned, and is
+//                  at least large enough to hold the free list link.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int pool_init(struct pool *p, const char *name, unsigned int block_size,
+              unsigned int count, unsigned int align)
+{
+    unsigned char *mem;
+    unsigned int i;
+
+    if (align == 0)
+        align = CACHE_LINE_SIZE;
+    if (block_size < sizeof(void *))
+        block_size = sizeof(void *);
+    block_size = (block_size + align - 1) & ~(align - 1);
+
+    mem = arena_alloc(block_size * count, align);
+    if (mem == 0)
+        return 0;
+
+    p->name = name;
+    p->block_size = block_size;
+    p->count = count;
+    p->in_use = 0;
+    p->high_water = 0;
+    p->failures = 0;
+
+    // Build the free list, lowest address first
+    p->free_list = 0;
+    for (i = count; i > 0; i--) {
+        *(void **)(mem + (i - 1) * block_size) = p->free_list;
+        p->free_list = mem + (i - 1) * block_size;
+    }
+
+    p->next = pools;
+    pools = p;
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       pool_alloc
+//
+//  Arguments:      p - the pool
+//
+//  Returns:        pointer to a block, or 0 if the pool is empty
+//
+//  Description:    Takes the first block off the free list in constant time
+//                  and updates the usage statistics. Safe to call from both
+//                  the main loop and interrupt handlers.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void *pool_alloc(struct pool *p)
+{
+    unsigned long flags;
+    void *block;
+
+    flags = irq_save();
+
+    block = p->free_list;
+    if (block) {
+        p->free_list = *(void **)block;
+        if (++p->in_use > p->high_water)
+            p->high_water = p->in_use;
+    } else {
+        p->failures++;
+    }
+
+    irq_restore(flags);
+
+    return block;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       pool_free
+//
+//  Arguments:      p - the pool the block came from
+//                  block - the block to return
+//
+//  Returns:        void
+//
+//  Description:    Pushes the block back onto the free list in constant time.
+//                  Safe to call from both the main loop and interrupt
+//                  handlers.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void pool_free(struct pool *p, void *block)
+{
+    unsigned long flags;
+
+    flags = irq_save();
+
+    *(void **)block = p->free_list;
+    p->free_list = block;
+    p->in_use--;
+
+    irq_restore(flags);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       pool_report_all
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Prints arena usage and, for every pool, its block size,
+//                  block count, current use, high-water mark, and number of
+//                  failed allocations.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void pool_report_all(void)
+{
+    struct pool *p;
+
+    uart_puts("arena used:  0x");
+    uart_puthex(arena_used());
+    uart_puts(" of 0x");
+    uart_puthex(ARENA_SIZE);
+    uart_puts("  failures:  0x");
+    uart_puthex(arena_failures);
+    uart_puts("\n");
+
+    for (p = pools; p; p = p->next) {
+        uart_puts("pool ");
+        uart_puts((char *)p->name);
+        uart_puts(":  size 0x");
+        uart_puthex(p->block_size);
+        uart_puts("  count 0x");
+        uart_puthex(p->count);
+        uart_puts("  in use 0x");
+        uart_puthex(p->in_use);
+        uart_puts("  high 0x");
+        uart_puthex(p->high_water);
+        uart_puts("  failures 0x");
+        uart_puthex(p->failures);
+        uart_puts("\n");
+    }
+}
@@ -0,0 +1,36 @@
+// Static memory arena and fixed-block pools. There is no heap: all buffers
+// the firmware needs (queues, frame buffers, tables, stacks) are carved
+// out of one compile-time-sized arena during initialization, either
+// directly with arena_alloc() or as blocks of a pool.
+
+#ifndef ARENA_H
+#define ARENA_H
+
+// Total arena size in bytes
+#define ARENA_SIZE          (64 * 1024)
+
+// Cortex-A53 data cache line size, the default alignment for buffers that
+// are written by one context and read by another
+#define CACHE_LINE_SIZE     64
+
+struct pool {
+    const char *name;
+    void *free_list;            // singly linked list threaded through free blocks
+    unsigned int block_size;
+    unsigned int count;         // total blocks
+    unsigned int in_use;        // blocks currently allocated
+    unsigned int high_water;    // most blocks ever allocated at once
+    unsigned int failures;      // allocations refused because the pool was empty
+    struct pool *next;          // all pools, for reporting
+};
+
+void *arena_alloc(unsigned int size, unsigned int align);
+unsigned int arena_used(void);
+
+int pool_init(struct pool *p, const char *name, unsigned int block_size,
+              unsigned int count, unsigned int align);
+void *pool_alloc(struct pool *p);
+void pool_free(struct pool *p, void *block);
+void pool_report_all(void);
+
+#endif
@@ -0,0 +1,277 @@
+// This program is a resident serial chainloader. It is built into its own
+// kernel8.img (with start.S, uart.c, lz4.c, and crc32.c) and left on the SD
+// card. At power-up it moves itself out of the way of the load address,
+// announces itself on the UART, and waits for tools/sendimg.py to send a
+// framed, LZ4-compressed, CRC-checked image. The image is decompressed
+// straight into its load address and started, so redeploying new firmware
+// only needs a reset instead of rewriting the SD card.
+//
+// Protocol (all words little-endian):
+//   loader -> host   "\3\3\3"                       ready for a header,
+//                                                  repeated every second
+//                                                  until one starts
+//   host -> loader   "C359" load_addr raw_size packed_size crc32 header_crc
+//                    (packed_size 0 means the image is sent uncompressed;
+//                    header_crc covers the four words before it)
+//   loader -> host   "OK", "HE" if header_crc is wrong, "SE" if the
+//                    image does not fit, or "TO" if the header stalls
+//   host -> loader   packed_size (or raw_size) bytes of image
+//   loader -> host   "OK" rx_us unpack_us, then jumps to load_addr
+//                    "CE" (bad CRC), "DE" (bad LZ4 data), or "TO"
+//                    (transfer stalled), then waits for a new header
+
+// Include files
+#include "uart.h"
+#include "gpio.h"
+#include "systimer.h"
+#include "lz4.h"
+#include "crc32.h"
+
+// Address the firmware loads kernel8.img at, and where the loader moves
+// itself to. Images may use everything between the two; compressed data
+// is staged above the loader.
+#define KERNEL_BASE         0x00080000
+#define LOADER_BASE         0x02000000
+#define STAGING_BASE        0x02100000
+#define STAGING_SIZE        0x01000000
+
+// Give up on a transfer after this long without a byte, in microseconds
+#define RX_TIMEOUT_US       1000000
+
+// Repeat the ready signal this often while no host is talking to us, so a
+// host that connects after the loader started still sees it
+#define READY_INTERVAL_US   1000000
+
+// Mini UART data and line status registers, for raw byte I/O (uart_getc
+// translates carriage returns, which would corrupt binary data)
+#define AUX_MU_IO           ((volatile unsigned int *)(MMIO_BASE + 0x00215040))
+#define AUX_MU_LSR          ((volatile unsigned int *)(MMIO_BASE + 0x00215054))
+
+#define FRAME_MAGIC         0x39353343      // "C359"
+
+// End of the loader image, from the linker script
+extern char _end[];
+
+// Function prototypes
+void loader_main();
+int getRaw(unsigned int timeout_us);
+void sendReady();
+void waitMagic();
+int getWord(unsigned int *w);
+void putWord(unsigned int w);
+void reply(char *code);
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       main
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Copies the loader from KERNEL_BASE to LOADER_BASE and
+//                  continues in the copy. The code only uses PC-relative
+//                  addressing (the default small code model), so the copy
+//                  runs unchanged at its new address; the stack stays
+//                  below KERNEL_BASE.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void main()
+{
+    register unsigned long *src;
+    register unsigned long *dst;
+    register unsigned long size;
+    void (*relocated)(void);
+
+    src = (unsigned long *)KERNEL_BASE;
+    dst = (unsigned long *)LOADER_BASE;
+    size = ((unsigned long)_end - KERNEL_BASE + 7) / 8;
+    while (size--)
+        *dst++ = *src++;
+
+    // Make the copied instructions visible, then jump into the copy
+    asm volatile("dsb sy\n\tic iallu\n\tdsb sy\n\tisb" ::: "memory");
+    relocated = (void (*)(void))((unsigned long)loader_main - KERNEL_BASE + LOADER_BASE);
+    relocated();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       loader_main
+//
+//  Arguments:      none
+//
+//  Returns:        does not return
+//
+//  Description:    Receives images until one arrives intact, then starts it.
+//                  Receive and decompression times are measured on the
+//                  system timer and reported to the host.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void loader_main()
+{
+    unsigned int header[5];
+    unsigned int load_addr, raw_size, packed_size, crc;
+    unsigned int count, i, t0, t1, t2;
+    unsigned char *dest;
+    unsigned char *rx;
+    int c, n;
+
+    uart_init();
+    uart_puts("\nchainloader ready\n");
+
+    while (1) {
+        // Ask for a header and wait for the magic word
+        waitMagic();
+
+        // A stalled header (a host that died, or line noise that happened
+        // to match the magic) goes back to waiting, not forever
+        for (i = 0; i < 5; i++) {
+            if (!getWord(&header[i]))
+                break;
+        }
+        if (i < 5) {
+            reply("TO");
+            continue;
+        }
+        if (crc32((unsigned char *)header, 4 * sizeof(header[0])) != header[4]) {
+            reply("HE");
+            continue;
+        }
+        load_addr = header[0];
+        raw_size = header[1];
+        packed_size = header[2];
+        crc = header[3];
+
+        // Written so that nothing can wrap around 32 bits
+        if (load_addr < KERNEL_BASE || load_addr >= LOADER_BASE ||
+            raw_size > LOADER_BASE - load_addr || packed_size > STAGING_SIZE) {
+            reply("SE");
+            continue;
+        }
+        reply("OK");
+
+        // Compressed images are staged, raw images go straight to the
+        // load address
+        dest = (unsigned char *)(unsigned long)load_addr;
+        rx = packed_size ? (unsigned char *)STAGING_BASE : dest;
+        count = packed_size ? packed_size : raw_size;
+
+        t0 = *SYSTIMER_CLO;
+        for (i = 0; i < count; i++) {
+            c = getRaw(RX_TIMEOUT_US);
+            if (c < 0)
+                break;
+            rx[i] = c;
+        }
+        if (i < count) {
+            reply("TO");
+            continue;
+        }
+
+        t1 = *SYSTIMER_CLO;
+        if (packed_size) {
+            n = lz4_decompress(rx, packed_size, dest, raw_size);
+            if (n != (int)raw_size) {
+                reply("DE");
+                continue;
+            }
+        }
+        t2 = *SYSTIMER_CLO;
+
+        if (crc32(dest, raw_size) != crc) {
+            reply("CE");
+            continue;
+        }
+
+        reply("OK");
+        putWord(t1 - t0);
+        putWord(t2 - t1);
+
+        // Let the last bytes leave the UART, then start the new image
+        while (!(*AUX_MU_LSR & 0x40)) {
+            asm volatile("nop");
+        }
+        asm volatile("dsb sy\n\tic iallu\n\tdsb sy\n\tisb" ::: "memory");
+        ((void (*)(void))(unsigned long)load_addr)();
+    }
+}
+
+
+// Read one raw byte, or return -1 if none arrives within timeout_us
+int getRaw(unsigned int timeout_us)
+{
+    unsigned int start = *SYSTIMER_CLO;
+
+    while (!(*AUX_MU_LSR & 0x01)) {
+        if (*SYSTIMER_CLO - start >= timeout_us)
+            return -1;
+    }
+
+    return *AUX_MU_IO & 0xFF;
+}
+
+// Signal that a header can be sent
+void sendReady()
+{
+    uart_send(3);
+    uart_send(3);
+    uart_send(3);
+}
+
+// Signal ready, then skip bytes until the last four received are the
+// frame magic, signalling again whenever the line stays quiet
+void waitMagic()
+{
+    unsigned int w = 0;
+    int c;
+
+    sendReady();
+    while (w != FRAME_MAGIC) {
+        c = getRaw(READY_INTERVAL_US);
+        if (c < 0) {
+            sendReady();
+            continue;
+        }
+        w = (w >> 8) | ((unsigned int)c << 24);
+    }
+}
+
+// Read a little-endian word into *w. Returns 0 if a byte does not arrive
+// within RX_TIMEOUT_US.
+int getWord(unsigned int *w)
+{
+    unsigned int i;
+    int c;
+
+    *w = 0;
+    for (i = 0; i < 4; i++) {
+        c = getRaw(RX_TIMEOUT_US);
+        if (c < 0)
+            return 0;
+        *w |= (unsigned int)c << (i * 8);
+    }
+
+    return 1;
+}
+
+void putWord(unsigned int w)
+{
+    unsigned int i;
+
+    for (i = 0; i < 4; i++) {
+        uart_send(w & 0xFF);
+        w >>= 8;
+    }
+}
+
+void reply(char *code)
+{
+    uart_send(code[0]);
+    uart_send(code[1]);
+}
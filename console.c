@@ -0,0 +1,35 @@
+
+// Header files
+#include "uart.h"
+#include "console.h"
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       console_putdec
+//
+//  Arguments:      d - the value to print
+//
+//  Returns:        void
+//
+//  Description:    Prints an unsigned value in decimal, without leading
+//                  zeros.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void console_putdec(unsigned int d)
+{
+    char buf[11];
+    int i;
+
+    // Build the digits from the right
+    i = sizeof(buf) - 1;
+    buf[i] = '\0';
+    do {
+        buf[--i] = '0' + d % 10;
+        d /= 10;
+    } while (d);
+
+    uart_puts(&buf[i]);
+}
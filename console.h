@@ -0,0 +1,9 @@
+// Small formatting helpers for status output on the UART console, used
+// where hexadecimal is awkward to read (clock rates, temperatures, counts).
+
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+void console_putdec(unsigned int d);
+
+#endif
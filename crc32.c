@@ -0,0 +1,42 @@
+
+// Header files
+#include "crc32.h"
+
+// CRC of each 4-bit value; a 16-entry table keeps the chainloader small
+// while still doing two table steps per byte instead of eight shifts
+static const unsigned int crc_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC,
+    0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C,
+    0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       crc32_update
+//
+//  Arguments:      crc - CRC of the data so far (0 to start)
+//                  p - next block of data
+//                  len - length of the block in bytes
+//
+//  Returns:        CRC of all the data including this block
+//
+//  Description:    Matches zlib's crc32(), so the host can check images
+//                  with the standard library.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int crc32_update(unsigned int crc, const unsigned char *p,
+                          unsigned int len)
+{
+    crc = ~crc;
+    while (len--) {
+        crc ^= *p++;
+        crc = (crc >> 4) ^ crc_nibble[crc & 0xF];
+        crc = (crc >> 4) ^ crc_nibble[crc & 0xF];
+    }
+
+    return ~crc;
+}
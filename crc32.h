@@ -0,0 +1,12 @@
+// CRC-32 (IEEE 802.3, as used by zlib) for checking transferred images.
+
+#ifndef CRC32_H
+#define CRC32_H
+
+unsigned int crc32_update(unsigned int crc, const unsigned char *p,
+                          unsigned int len);
+
+// CRC of a whole buffer
+#define crc32(p, len)   crc32_update(0, (p), (len))
+
+#endif
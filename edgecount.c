@@ -0,0 +1,431 @@
+
+// Header files
+#include "uart.h"
+#include "gpio.h"
+#include "irq.h"
+#include "systimer.h"
+#include "pin.h"
+#include "console.h"
+#include "edgecount.h"
+#include "irqvec.h"
+
+// Quadrature decoding: position change for each (previous AB, current AB)
+// pair. Both inputs changing at once is a missed step and counts as an
+// error instead.
+#define QUAD_ERROR  2
+static const signed char quad_delta[16] = {
+     0, +1, -1, QUAD_ERROR,
+    -1,  0, QUAD_ERROR, +1,
+    +1, QUAD_ERROR,  0, -1,
+    QUAD_ERROR, -1, +1,  0
+};
+
+struct encoder {
+    unsigned int a;
+    unsigned int b;
+    unsigned int prev;          // last AB state
+    volatile int position;
+    volatile unsigned int errors;
+};
+
+// Configuration
+unsigned int edgecount_mask;
+static unsigned int count_method;
+static unsigned int period;
+static struct encoder encoders[EDGECOUNT_MAX_ENCODERS];
+static unsigned int encoder_count;
+
+// Updated by the interrupt handlers
+static volatile unsigned int counts[32];
+static volatile unsigned int last_levels;
+static volatile struct edgecount_stats stats;
+
+// Per-pin rates, updated once a second in task context
+static unsigned int snap[32];
+static unsigned int rate[32];
+static unsigned int snap_time;
+
+
+// Schedule the next compare 1 interrupt
+IRQ_CODE static void arm_timer(unsigned int when)
+{
+    *SYSTIMER_C1 = when;
+    *SYSTIMER_CS = SYSTIMER_CS_M1;
+}
+
+// Count the edges in changed, update the encoders from the current levels,
+// and record how many edges this invocation absorbed
+IRQ_CODE static void absorb(unsigned int changed, unsigned int levels)
+{
+    struct encoder *e;
+    unsigned int m;
+    unsigned int n = 0;
+    unsigned int ab;
+    int delta;
+
+    for (m = changed; m; m &= m - 1) {
+        counts[__builtin_ctz(m)]++;
+        n++;
+    }
+
+    for (e = encoders; e < encoders + encoder_count; e++) {
+        if (!(changed & ((0x1u << e->a) | (0x1u << e->b))))
+            continue;
+        ab = (((levels >> e->a) & 0x1) << 1) | ((levels >> e->b) & 0x1);
+        delta = quad_delta[(e->prev << 2) | ab];
+        if (delta == QUAD_ERROR)
+            e->errors++;
+        else
+            e->position += delta;
+        e->prev = ab;
+    }
+
+    last_levels = levels;
+
+    stats.irqs++;
+    stats.edges += n;
+    if (n > stats.max_edges)
+        stats.max_edges = n;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_init
+//
+//  Arguments:      method - EDGECOUNT_SAMPLED or EDGECOUNT_RATE_LIMIT
+//                  period_us - sample period, or GPIO interrupt hold-off
+//
+//  Returns:        void
+//
+//  Description:    Resets the counter. Pins and encoders are added next,
+//                  then edgecount_start() turns counting on.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void edgecount_init(unsigned int method, unsigned int period_us)
+{
+    unsigned int i;
+
+    count_method = method;
+    period = period_us;
+    edgecount_mask = 0;
+    encoder_count = 0;
+    for (i = 0; i < 32; i++)
+        counts[i] = snap[i] = rate[i] = 0;
+    stats.irqs = stats.edges = stats.max_edges = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_add_pin
+//
+//  Arguments:      pin - bank 0 GPIO pin to count edges on
+//                  pull - PIN_PULL_NONE, PIN_PULL_DOWN, or PIN_PULL_UP
+//
+//  Returns:        void
+//
+//  Description:    Makes the pin an input owned by the counter. Both edges
+//                  are counted.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void edgecount_add_pin(unsigned int pin, unsigned int pull)
+{
+    if (pin >= 32)
+        return;
+
+    pin_function(pin, PIN_INPUT);
+    pin_pull(pin, pull);
+    edgecount_mask |= 0x1u << pin;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_add_encoder
+//
+//  Arguments:      pin_a, pin_b - bank 0 pins of the encoder's two phases
+//                  pull - pull applied to both pins
+//
+//  Returns:        the encoder number, or -1 if no more can be added
+//
+//  Description:    Adds both pins as counting pins and decodes them as a
+//                  quadrature pair, one position step per edge.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int edgecount_add_encoder(unsigned int pin_a, unsigned int pin_b,
+                          unsigned int pull)
+{
+    struct encoder *e;
+
+    if (encoder_count >= EDGECOUNT_MAX_ENCODERS || pin_a >= 32 || pin_b >= 32)
+        return -1;
+
+    edgecount_add_pin(pin_a, pull);
+    edgecount_add_pin(pin_b, pull);
+
+    e = &encoders[encoder_count];
+    e->a = pin_a;
+    e->b = pin_b;
+    e->position = 0;
+    e->errors = 0;
+
+    return encoder_count++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_start
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Takes the starting levels, then either starts the sample
+//                  timer, or enables edge detection on the counting pins
+//                  and the system timer compare 1 interrupt used to end
+//                  each hold-off.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void edgecount_start(void)
+{
+    struct encoder *e;
+    unsigned int levels;
+    unsigned int m;
+
+    levels = *GPLEV0;
+    last_levels = levels;
+    for (e = encoders; e < encoders + encoder_count; e++)
+        e->prev = (((levels >> e->a) & 0x1) << 1) | ((levels >> e->b) & 0x1);
+
+    if (count_method == EDGECOUNT_RATE_LIMIT) {
+        for (m = edgecount_mask; m; m &= m - 1)
+            pin_edge(__builtin_ctz(m), PIN_EDGE_BOTH);
+        *GPEDS0 = edgecount_mask;
+    } else {
+        arm_timer(*SYSTIMER_CLO + period);
+    }
+
+    // Enable IRQ 1, system timer compare 1
+    *IRQ_ENABLE_IRQS_1 = (0x1 << 1);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_gpio_irq
+//
+//  Arguments:      pending - GPEDS0 bits of counting pins, already cleared
+//                  levels - GPLEV0 at the time of the interrupt
+//
+//  Returns:        void
+//
+//  Description:    Called by the IRQ handler in the rate-limited method.
+//                  Counts every pending edge at once, then masks the GPIO
+//                  interrupt until the hold-off expires. Edges arriving in
+//                  the meantime stay latched in GPEDS0 and are absorbed by
+//                  the interrupt taken as soon as it is unmasked.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void edgecount_gpio_irq(unsigned int pending, unsigned int levels)
+{
+    absorb(pending, levels);
+
+    *IRQ_DISABLE_IRQS_2 = (0x1 << 20);
+    arm_timer(*SYSTIMER_CLO + period);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_timer_irq
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    System timer compare 1 handler. In the sampled method it
+//                  reads GPLEV0 once, counts every counting pin whose level
+//                  changed since the last sample, and schedules the next
+//                  sample a fixed period after this one. In the rate-limited
+//                  method it ends the hold-off by unmasking the GPIO
+//                  interrupt.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void edgecount_timer_irq(void)
+{
+    unsigned int levels;
+    unsigned int next;
+
+    if (count_method == EDGECOUNT_RATE_LIMIT) {
+        *SYSTIMER_CS = SYSTIMER_CS_M1;
+        *IRQ_ENABLE_IRQS_2 = (0x1 << 20);
+        return;
+    }
+
+    // Keep a fixed sample rate, but never schedule into the past
+    next = *SYSTIMER_C1 + period;
+    if ((int)(next - *SYSTIMER_CLO) <= 0)
+        next = *SYSTIMER_CLO + period;
+    arm_timer(next);
+
+    levels = *GPLEV0;
+    absorb((levels ^ last_levels) & edgecount_mask, levels);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_count
+//                  edgecount_rate
+//                  edgecount_position
+//
+//  Arguments:      pin - counting pin / encoder - encoder number
+//
+//  Returns:        edges counted since start, edges per second over the
+//                  last second, or the encoder's position in steps
+//
+//  Description:    Read-only views of the counters for task context.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int edgecount_count(unsigned int pin)
+{
+    return pin < 32 ? counts[pin] : 0;
+}
+
+unsigned int edgecount_rate(unsigned int pin)
+{
+    return pin < 32 ? rate[pin] : 0;
+}
+
+int edgecount_position(unsigned int encoder)
+{
+    return encoder < encoder_count ? encoders[encoder].position : 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_get_stats
+//
+//  Arguments:      s - receives the interrupt statistics
+//
+//  Returns:        void
+//
+//  Description:    Reports how many handler invocations looked at the
+//                  counting pins and how many edges they absorbed, so the
+//                  coalescing factor is edges / irqs.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void edgecount_get_stats(struct edgecount_stats *s)
+{
+    s->irqs = stats.irqs;
+    s->edges = stats.edges;
+    s->max_edges = stats.max_edges;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_update
+//
+//  Arguments:      now - current system timer value
+//
+//  Returns:        void
+//
+//  Description:    Recomputes the per-pin rates once a second. Call this
+//                  from the main loop.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void edgecount_update(unsigned int now)
+{
+    unsigned int elapsed = now - snap_time;
+    unsigned int m, pin, c;
+
+    if (elapsed < 1000000)
+        return;
+
+    for (m = edgecount_mask; m; m &= m - 1) {
+        pin = __builtin_ctz(m);
+        c = counts[pin];
+        rate[pin] = (unsigned int)((unsigned long)(c - snap[pin]) * 1000000 / elapsed);
+        snap[pin] = c;
+    }
+    snap_time = now;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       edgecount_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Prints the count and rate of every counting pin, every
+//                  encoder position, and the edges absorbed per interrupt.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void edgecount_report(void)
+{
+    struct edgecount_stats s;
+    unsigned int m, pin, i;
+    int pos;
+
+    for (m = edgecount_mask; m; m &= m - 1) {
+        pin = __builtin_ctz(m);
+        uart_puts("pin ");
+        console_putdec(pin);
+        uart_puts(":  count ");
+        console_putdec(counts[pin]);
+        uart_puts("  rate ");
+        console_putdec(rate[pin]);
+        uart_puts("/s\n");
+    }
+
+    for (i = 0; i < encoder_count; i++) {
+        pos = encoders[i].position;
+        uart_puts("encoder ");
+        console_putdec(i);
+        uart_puts(":  position ");
+        if (pos < 0) {
+            uart_puts("-");
+            pos = -pos;
+        }
+        console_putdec(pos);
+        uart_puts("  errors ");
+        console_putdec(encoders[i].errors);
+        uart_puts("\n");
+    }
+
+    edgecount_get_stats(&s);
+    uart_puts("edge irqs:  ");
+    console_putdec(s.irqs);
+    uart_puts("  edges:  ");
+    console_putdec(s.edges);
+    uart_puts("  max per irq:  ");
+    console_putdec(s.max_edges);
+    uart_puts("\n");
+}
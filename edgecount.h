@@ -0,0 +1,56 @@
+// Edge counting for fast GPIO inputs (tachometers, pulse counters, rotary
+// encoders). Instead of one interrupt per edge handled as a button press,
+// edges are accumulated per pin with interrupts coalesced in one of two
+// ways:
+//
+//   EDGECOUNT_SAMPLED    - a periodic system timer (compare 1) interrupt
+//                          reads GPLEV0 once and counts every level change
+//                          on all counting pins. No GPIO interrupts are
+//                          taken for them at all. Exact while each pin
+//                          changes at most once per sample period.
+//   EDGECOUNT_RATE_LIMIT - counting pins use edge detection. The GPIO
+//                          interrupt absorbs every pending edge in one
+//                          GPEDS0 read and bulk clear, then masks the GPIO
+//                          interrupt for the hold-off period (compare 1
+//                          unmasks it), so a burst is folded into one
+//                          handler invocation. Each pin contributes at most
+//                          one edge per hold-off.
+//
+// Only bank 0 pins (0 - 31) can count.
+
+#ifndef EDGECOUNT_H
+#define EDGECOUNT_H
+
+// Coalescing methods
+#define EDGECOUNT_SAMPLED       0
+#define EDGECOUNT_RATE_LIMIT    1
+
+#define EDGECOUNT_MAX_ENCODERS  2
+
+// Mask of bank 0 pins owned by the edge counter, read by the IRQ handler
+extern unsigned int edgecount_mask;
+
+// How much work each interrupt absorbed
+struct edgecount_stats {
+    unsigned int irqs;          // handler invocations that looked at pins
+    unsigned int edges;         // edges counted over all of them
+    unsigned int max_edges;     // most edges absorbed by one invocation
+};
+
+void edgecount_init(unsigned int method, unsigned int period_us);
+void edgecount_add_pin(unsigned int pin, unsigned int pull);
+int edgecount_add_encoder(unsigned int pin_a, unsigned int pin_b,
+                          unsigned int pull);
+void edgecount_start(void);
+
+void edgecount_gpio_irq(unsigned int pending, unsigned int levels);
+void edgecount_timer_irq(void);
+
+unsigned int edgecount_count(unsigned int pin);
+unsigned int edgecount_rate(unsigned int pin);
+int edgecount_position(unsigned int encoder);
+void edgecount_get_stats(struct edgecount_stats *s);
+void edgecount_update(unsigned int now);
+void edgecount_report(void);
+
+#endif
@@ -0,0 +1,114 @@
+
+// Header files
+#include "eventq.h"
+#include "irqvec.h"
+
+// Order the slot write/read against the index update. On a single core only
+// the compiler barrier matters; the dmb keeps the queue correct if the
+// consumer is ever moved to another core.
+#define eventq_barrier()    asm volatile("dmb ish" ::: "memory")
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       eventq_init
+//
+//  Arguments:      q - the queue to initialize
+//                  buf - backing storage for the events
+//                  size - number of slots in buf, must be a power of 2
+//
+//  Returns:        void
+//
+//  Description:    Attaches the backing storage to the queue and empties it.
+//                  Must be called before interrupts that push to the queue
+//                  are enabled.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void eventq_init(struct eventq *q, struct input_event *buf, unsigned int size)
+{
+    q->buf = buf;
+    q->mask = size - 1;
+    q->head = 0;
+    q->tail = 0;
+    q->dropped = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       eventq_push
+//
+//  Arguments:      q - the queue
+//                  pin - GPIO pin number the edge occurred on
+//                  edge - EDGE_RISING or EDGE_FALLING
+//                  timestamp - system timer value when the edge was seen
+//
+//  Returns:        1 if the event was queued, 0 if the queue was full
+//
+//  Description:    Producer side, called from the IRQ handler. Does a fixed,
+//                  small amount of work: one slot write and one index store.
+//                  A full queue drops the new event and counts it, rather
+//                  than overwriting events the consumer has not seen yet.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE int eventq_push(struct eventq *q, unsigned int pin, unsigned int edge,
+                unsigned int timestamp)
+{
+    unsigned int head = q->head;
+    struct input_event *slot;
+
+    // Check for a full queue
+    if (head - q->tail > q->mask) {
+        q->dropped++;
+        return 0;
+    }
+
+    // Fill in the slot, then publish it by advancing the head
+    slot = &q->buf[head & q->mask];
+    slot->pin = pin;
+    slot->edge = edge;
+    slot->timestamp = timestamp;
+
+    eventq_barrier();
+    q->head = head + 1;
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       eventq_pop
+//
+//  Arguments:      q - the queue
+//                  ev - receives the oldest event
+//
+//  Returns:        1 if an event was removed, 0 if the queue was empty
+//
+//  Description:    Consumer side, called from the main loop. Safe to call
+//                  with interrupts enabled.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int eventq_pop(struct eventq *q, struct input_event *ev)
+{
+    unsigned int tail = q->tail;
+
+    // Check for an empty queue
+    if (tail == q->head)
+        return 0;
+
+    // Copy the slot out before handing it back to the producer
+    eventq_barrier();
+    *ev = q->buf[tail & q->mask];
+
+    eventq_barrier();
+    q->tail = tail + 1;
+
+    return 1;
+}
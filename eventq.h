@@ -0,0 +1,34 @@
+// Single-producer / single-consumer queue of timestamped GPIO input events.
+// The IRQ handler is the only producer and the main loop is the only
+// consumer, so no locking is needed: each side owns one index and the
+// other side only ever reads it.
+
+#ifndef EVENTQ_H
+#define EVENTQ_H
+
+// Edge types recorded in an event
+#define EDGE_FALLING    0
+#define EDGE_RISING     1
+
+// One edge seen on one pin, stamped with the system timer (microseconds)
+struct input_event {
+    unsigned char pin;
+    unsigned char edge;
+    unsigned short reserved;
+    unsigned int timestamp;
+};
+
+struct eventq {
+    struct input_event *buf;
+    unsigned int mask;              // capacity - 1 (capacity is a power of 2)
+    volatile unsigned int head;     // written by the producer only
+    volatile unsigned int tail;     // written by the consumer only
+    volatile unsigned int dropped;  // events lost because the queue was full
+};
+
+void eventq_init(struct eventq *q, struct input_event *buf, unsigned int size);
+int eventq_push(struct eventq *q, unsigned int pin, unsigned int edge,
+                unsigned int timestamp);
+int eventq_pop(struct eventq *q, struct input_event *ev);
+
+#endif
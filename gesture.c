@@ -0,0 +1,251 @@
+
+// Header files
+#include "arena.h"
+#include "gesture.h"
+
+// Number of recognized gestures that can be waiting for the main loop
+#define GESTURE_QUEUE_SIZE  8
+
+// Per-pin recognizer state, kept as bit masks indexed by GPIO pin number
+static unsigned int tracked;        // pins the recognizer listens to
+static unsigned int held;           // pins currently pressed
+static unsigned int chorded;        // pins taking part in a chord
+static unsigned int long_sent;      // pins whose long press was reported
+static unsigned int pending;        // short presses waiting out the double window
+static unsigned int doubled;        // pins on the second press of a double
+
+// Per-pin timestamps
+static unsigned int last_edge[32];
+static unsigned int down_time[32];
+static unsigned int up_time[32];
+static unsigned int held_for[32];
+
+// Recognized gestures waiting to be collected, oldest first. Entries come
+// from a pool, so its high-water mark shows how far the main loop falls
+// behind.
+struct gesture_entry {
+    struct gesture g;
+    struct gesture_entry *next;
+};
+
+static struct pool gesture_pool;
+static struct gesture_entry *out_head;
+static struct gesture_entry *out_tail;
+
+
+// Queue a recognized gesture for gesture_poll(). When the pool is empty
+// the gesture is dropped and counted as a pool failure.
+static void emit(unsigned int type, unsigned int pins, unsigned int timestamp,
+                 unsigned int duration)
+{
+    struct gesture_entry *e;
+
+    e = pool_alloc(&gesture_pool);
+    if (e == 0)
+        return;
+
+    e->g.type = type;
+    e->g.pins = pins;
+    e->g.timestamp = timestamp;
+    e->g.duration = duration;
+    e->next = 0;
+
+    if (out_tail)
+        out_tail->next = e;
+    else
+        out_head = e;
+    out_tail = e;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       gesture_init
+//
+//  Arguments:      pin_mask - bit mask of the GPIO pins (0 - 31) to track
+//
+//  Returns:        1 on success, 0 if the gesture pool could not be allocated
+//
+//  Description:    Resets the recognizer and selects the pins it listens to.
+//                  Events for any other pin are ignored by gesture_feed().
+//                  The pool of queued gestures is carved out of the arena
+//                  on the first call and emptied on later ones.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int gesture_init(unsigned int pin_mask)
+{
+    struct gesture g;
+
+    if (gesture_pool.count == 0 &&
+        !pool_init(&gesture_pool, "gesture", sizeof(struct gesture_entry),
+                   GESTURE_QUEUE_SIZE, sizeof(void *)))
+        return 0;
+
+    tracked = pin_mask;
+    held = chorded = long_sent = pending = doubled = 0;
+    while (gesture_poll(0, &g))
+        ;
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       gesture_feed
+//
+//  Arguments:      ev - a raw edge event taken from the input event queue
+//
+//  Returns:        void
+//
+//  Description:    Advances the recognizer with one edge. A rising edge is a
+//                  press and a falling edge is a release (the buttons pull
+//                  the pin to 3.3V). Edges closer together than the
+//                  debounce time, and edges that do not change the pin's
+//                  state, are treated as contact bounce and dropped.
+//
+//                  A second button pressed within the chord window of a
+//                  held button produces a chord immediately; buttons in a
+//                  chord produce nothing else until they are released.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void gesture_feed(const struct input_event *ev)
+{
+    unsigned int pin = ev->pin;
+    unsigned int bit = 0x1 << pin;
+    unsigned int t = ev->timestamp;
+    unsigned int others, mask, o;
+
+    if (pin >= 32 || !(tracked & bit))
+        return;
+
+    // Drop contact bounce
+    if (t - last_edge[pin] < GESTURE_DEBOUNCE_US)
+        return;
+
+    if (ev->edge == EDGE_RISING) {
+        if (held & bit)
+            return;
+        last_edge[pin] = t;
+        held |= bit;
+        down_time[pin] = t;
+
+        // Join an existing chord silently
+        if (chorded) {
+            chorded |= bit;
+            pending &= ~bit;
+            return;
+        }
+
+        // Start a chord if another button went down only just before
+        others = held & ~bit & ~long_sent;
+        for (mask = others; mask; mask &= mask - 1) {
+            o = __builtin_ctz(mask);
+            if (t - down_time[o] < GESTURE_CHORD_US) {
+                chorded = held;
+                pending &= ~held;
+                doubled &= ~held;
+                emit(GESTURE_CHORD, held, t, 0);
+                return;
+            }
+        }
+
+        // A press soon after a short press is the second half of a double
+        if (pending & bit) {
+            pending &= ~bit;
+            if (t - up_time[pin] < GESTURE_DOUBLE_US)
+                doubled |= bit;
+            else
+                emit(GESTURE_SHORT_PRESS, bit, t, held_for[pin]);
+        }
+    } else {
+        if (!(held & bit))
+            return;
+        last_edge[pin] = t;
+        held &= ~bit;
+        held_for[pin] = t - down_time[pin];
+
+        // Releases that end a chord or a reported long press are silent
+        if (chorded & bit) {
+            chorded &= ~bit;
+            long_sent &= ~bit;
+            return;
+        }
+        if (long_sent & bit) {
+            long_sent &= ~bit;
+            return;
+        }
+
+        if (held_for[pin] >= GESTURE_LONG_US) {
+            doubled &= ~bit;
+            emit(GESTURE_LONG_PRESS, bit, t, held_for[pin]);
+        } else if (doubled & bit) {
+            doubled &= ~bit;
+            emit(GESTURE_DOUBLE_PRESS, bit, t, held_for[pin]);
+        } else {
+            // Wait to see whether a second press follows
+            pending |= bit;
+            up_time[pin] = t;
+        }
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       gesture_poll
+//
+//  Arguments:      now - current system timer value
+//                  g - receives the next recognized gesture
+//
+//  Returns:        1 if a gesture was returned, 0 if there is none
+//
+//  Description:    Resolves the gestures that depend on time passing rather
+//                  than on an edge: a long press is reported as soon as the
+//                  threshold is reached (without waiting for the release),
+//                  and a short press is reported once the double press
+//                  window has closed. Call this regularly from the main loop.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int gesture_poll(unsigned int now, struct gesture *g)
+{
+    struct gesture_entry *e;
+    unsigned int mask, pin;
+
+    // Long presses still being held
+    for (mask = held & ~chorded & ~long_sent; mask; mask &= mask - 1) {
+        pin = __builtin_ctz(mask);
+        if (now - down_time[pin] >= GESTURE_LONG_US) {
+            long_sent |= 0x1 << pin;
+            doubled &= ~(0x1 << pin);
+            emit(GESTURE_LONG_PRESS, 0x1 << pin, now, now - down_time[pin]);
+        }
+    }
+
+    // Short presses whose double window has expired
+    for (mask = pending & ~held; mask; mask &= mask - 1) {
+        pin = __builtin_ctz(mask);
+        if (now - up_time[pin] >= GESTURE_DOUBLE_US) {
+            pending &= ~(0x1 << pin);
+            emit(GESTURE_SHORT_PRESS, 0x1 << pin, now, held_for[pin]);
+        }
+    }
+
+    e = out_head;
+    if (e == 0)
+        return 0;
+
+    *g = e->g;
+    out_head = e->next;
+    if (out_head == 0)
+        out_tail = 0;
+    pool_free(&gesture_pool, e);
+
+    return 1;
+}
@@ -0,0 +1,33 @@
+// Button gesture recognizer. Runs in task context: it is fed the raw edge
+// events queued by the IRQ handler and turns them into short presses, long
+// presses, double presses, and chords (two or more buttons held together).
+
+#ifndef GESTURE_H
+#define GESTURE_H
+
+#include "eventq.h"
+
+// Gesture types
+#define GESTURE_SHORT_PRESS     1
+#define GESTURE_LONG_PRESS      2
+#define GESTURE_DOUBLE_PRESS    3
+#define GESTURE_CHORD           4
+
+// Timing thresholds, in microseconds
+#define GESTURE_DEBOUNCE_US     20000
+#define GESTURE_LONG_US         600000
+#define GESTURE_DOUBLE_US       300000
+#define GESTURE_CHORD_US        150000
+
+struct gesture {
+    unsigned int type;
+    unsigned int pins;          // bit mask of the pins involved
+    unsigned int timestamp;     // when the gesture was recognized
+    unsigned int duration;      // how long the press was held
+};
+
+int gesture_init(unsigned int pin_mask);
+void gesture_feed(const struct input_event *ev);
+int gesture_poll(unsigned int now, struct gesture *g);
+
+#endif
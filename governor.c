@@ -0,0 +1,197 @@
+
+// Header files
+#include "uart.h"
+#include "console.h"
+#include "mbox.h"
+#include "irqvec.h"
+#include "governor.h"
+
+// Clock limits reported by the firmware, and the rate we last set, in Hz
+static unsigned int min_rate;
+static unsigned int max_rate;
+static unsigned int cur_rate;
+
+// Latest thermal readings
+static unsigned int temp;
+static unsigned int max_temp;
+static unsigned int throttled;
+
+// Load accounting for the current window
+static unsigned int last_pass;
+static unsigned int window_start;
+static unsigned int busy_us;
+static unsigned long last_irq_ticks;
+static unsigned long idle_irq_ticks;
+static unsigned int irq_tick_rate;
+static unsigned int windows;
+static unsigned int load;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       governor_init
+//
+//  Arguments:      now - current system timer value
+//
+//  Returns:        void
+//
+//  Description:    Reads the ARM clock limits and the thermal limit from the
+//                  firmware, starts the first sampling window, and prints
+//                  the starting state.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void governor_init(unsigned int now)
+{
+    min_rate = mbox_get_min_clock_rate(MBOX_CLOCK_ARM);
+    max_rate = mbox_get_max_clock_rate(MBOX_CLOCK_ARM);
+    cur_rate = mbox_get_clock_rate(MBOX_CLOCK_ARM);
+    max_temp = mbox_get_max_temperature();
+    temp = mbox_get_temperature();
+    throttled = mbox_get_throttled();
+
+    last_pass = window_start = now;
+    busy_us = 0;
+    last_irq_ticks = irqvec_ticks();
+    idle_irq_ticks = 0;
+    irq_tick_rate = irqvec_tick_rate();
+    windows = 0;
+    load = 0;
+
+    governor_report();
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       governor_account
+//
+//  Arguments:      now - system timer value at the end of a main loop pass
+//                  busy - nonzero if the pass did useful work
+//
+//  Returns:        void
+//
+//  Description:    Charges the time since the previous pass to busy or
+//                  idle. Interrupts do most of the real work, so time spent
+//                  in them during an idle pass is charged to busy as well
+//                  (a busy pass already counts all of its time). At the end
+//                  of each window the load decides the next ARM clock: the
+//                  maximum rate above GOVERNOR_UP_LOAD, the minimum below
+//                  GOVERNOR_DOWN_LOAD, unchanged in between. The minimum is
+//                  also used whenever the SoC is close to its thermal limit
+//                  or the firmware reports it is throttling. If the thermal
+//                  limit could not be read it is retried with each
+//                  temperature sample, and meanwhile only the throttled
+//                  flags are used. Mailbox calls are only made when the
+//                  clock changes and when the temperature is due to be
+//                  sampled.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void governor_account(unsigned int now, unsigned int busy)
+{
+    unsigned int target;
+    unsigned int rate;
+    unsigned int hot;
+    unsigned long irq_ticks;
+
+    irq_ticks = irqvec_ticks();
+    if (busy)
+        busy_us += now - last_pass;
+    else
+        idle_irq_ticks += irq_ticks - last_irq_ticks;
+    last_irq_ticks = irq_ticks;
+    last_pass = now;
+
+    if (now - window_start < GOVERNOR_WINDOW_US)
+        return;
+
+    // Close the window
+    if (irq_tick_rate)
+        busy_us += idle_irq_ticks * 1000000 / irq_tick_rate;
+    load = busy_us * 100 / (now - window_start);
+    if (load > 100)
+        load = 100;
+    window_start = now;
+    busy_us = 0;
+    idle_irq_ticks = 0;
+
+    if (++windows >= GOVERNOR_TEMP_WINDOWS) {
+        windows = 0;
+        temp = mbox_get_temperature();
+        throttled = mbox_get_throttled();
+        if (max_temp == 0)
+            max_temp = mbox_get_max_temperature();
+    }
+
+    // A max_temp of 0 means the firmware did not report one, not that
+    // every temperature is too hot
+    hot = (max_temp && temp + GOVERNOR_TEMP_MARGIN >= max_temp) ||
+          (throttled & (MBOX_THROTTLED_CAPPED | MBOX_THROTTLED_NOW |
+                        MBOX_THROTTLED_SOFT_TEMP));
+
+    // Pick the next clock rate
+    target = cur_rate;
+    if (hot || load <= GOVERNOR_DOWN_LOAD)
+        target = min_rate;
+    else if (load >= GOVERNOR_UP_LOAD)
+        target = max_rate;
+
+    if (target != cur_rate && target != 0) {
+        rate = mbox_set_clock_rate(MBOX_CLOCK_ARM, target);
+        if (rate)
+            cur_rate = rate;
+        governor_report();
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       governor_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Prints the requested and measured ARM clock, the clock
+//                  limits, the temperature and the headroom left before the
+//                  firmware throttles (or that the limit is unknown), the
+//                  throttled flags, and the load over the last window.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void governor_report(void)
+{
+    unsigned int measured;
+
+    measured = mbox_get_measured_clock_rate(MBOX_CLOCK_ARM);
+
+    uart_puts("ARM clock:  ");
+    console_putdec(cur_rate / 1000000);
+    uart_puts(" MHz (measured ");
+    console_putdec(measured / 1000000);
+    uart_puts(" MHz, range ");
+    console_putdec(min_rate / 1000000);
+    uart_puts(" - ");
+    console_putdec(max_rate / 1000000);
+    uart_puts(" MHz)\n");
+
+    uart_puts("temperature:  ");
+    console_putdec(temp / 1000);
+    if (max_temp) {
+        uart_puts(" C  headroom:  ");
+        console_putdec(max_temp > temp ? (max_temp - temp) / 1000 : 0);
+        uart_puts(" C");
+    } else {
+        uart_puts(" C  headroom:  unknown (no max temperature)");
+    }
+    uart_puts("  throttled:  0x");
+    uart_puthex(throttled);
+    uart_puts("  load:  ");
+    console_putdec(load);
+    uart_puts("%\n");
+}
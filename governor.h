@@ -0,0 +1,28 @@
+// ARM clock governor. The main loop reports whether each pass did useful
+// work, and the IRQ entry code reports the time spent in interrupts; once
+// per sampling window the governor compares busy time against idle time
+// and moves the ARM clock between the firmware's minimum and maximum
+// rates, backing off when the SoC nears its thermal limit.
+
+#ifndef GOVERNOR_H
+#define GOVERNOR_H
+
+// Sampling window, in microseconds
+#define GOVERNOR_WINDOW_US      100000
+
+// Load thresholds, in percent busy over one window
+#define GOVERNOR_UP_LOAD        50
+#define GOVERNOR_DOWN_LOAD      10
+
+// Temperature is read every this many windows
+#define GOVERNOR_TEMP_WINDOWS   10
+
+// Stay at the minimum clock while within this many millidegrees of the
+// firmware's throttling temperature
+#define GOVERNOR_TEMP_MARGIN    5000
+
+void governor_init(unsigned int now);
+void governor_account(unsigned int now, unsigned int busy);
+void governor_report(void);
+
+#endif
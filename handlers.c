@@ -4,6 +4,11 @@
 #include "gpio.h"
 #include "irq.h"
 #include "sysreg.h"
+#include "pin.h"
+
+// Button pins, as wired for main.c
+#define BUTTON1_PIN 23
+#define BUTTON2_PIN 24
 
 // Reference to the global mode of operation variable
 extern unsigned int mode;
@@ -17,31 +22,29 @@ extern unsigned int mode;
 //
 //  Returns:        void
 //
-//  Description:    This function first prints out some basic information about
-//                  the state of the interrupt controller, GPIO pending
-//                  interrupts, and selected system registers. Determines if interrupt is
-//                  coming from pin 23 or pin 24. The interrupt is cleared,
-//                  and interrupt is handled to transition to the correct mode.
+//  Description:    Determines if the GPIO interrupt is coming from pin 23
+//                  or pin 24. The interrupt is cleared, and interrupt is
+//                  handled to transition to the correct mode.
 //
 ////////////////////////////////////////////////////////////////////////////////
 
 void IRQ_handler()
 {
-    // Handle GPIO interrupts in general
-    if (*IRQ_PENDING_2 == 0x00100000) {
-      uart_puts("tick");
+    // Handle GPIO interrupts in general (IRQ 52, GPIO_int[3]), whatever
+    // else is pending alongside them
+    if (*IRQ_PENDING_2 & (0x1 << 20)) {
         // Handle the interrupt associated with GPIO pin 23
-        if (*GPEDS0 == (0x1 << 23)) {
+        if (*GPEDS0 & PIN_BIT(BUTTON1_PIN)) {
             // Clear the interrupt
-            *GPEDS0 = (0x1 << 23);
+            *GPEDS0 = PIN_BIT(BUTTON1_PIN);
             // change the mode
             mode = 0;
         }
 
         //Handle interrupt associated with GPIO pin 24
-        if (*GPEDS0 == (0x1 << 24)) {
+        if (*GPEDS0 & PIN_BIT(BUTTON2_PIN)) {
             //Clear the interrupt
-            *GPEDS0 = (0x1 << 24);
+            *GPEDS0 = PIN_BIT(BUTTON2_PIN);
             //change the mode
             mode = 1;
         }
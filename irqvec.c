@@ -0,0 +1,324 @@
+
+// Header files
+#include "gpio.h"
+#include "uart.h"
+#include "console.h"
+#include "irqvec.h"
+
+// FIQ routing: bit 7 enables the FIQ, bits 0 - 6 pick the source, numbered
+// the same way as the IRQs in irqvec.h
+#define FIQ_CONTROL         ((volatile unsigned int *)(MMIO_BASE + 0x0000B20C))
+#define FIQ_ENABLE          (0x1 << 7)
+
+// Handler table indexed by IRQ number, read by the IRQ entry in vectors.S.
+// Each entry is 16 bytes: the handler, then the flags.
+struct irq_entry irq_table[IRQ_COUNT];
+
+// Time spent in IRQs, in CNTPCT_EL0 ticks, and with IRQVEC_STATS the
+// breakdown per entry path; updated by vectors.S
+unsigned long irq_total_ticks;
+struct irq_path_stats irq_stats[IRQ_PATH_COUNT];
+
+// Handler for the one source routed to FIQ, called by vectors.S
+irq_handler_t fiq_handler;
+
+// Frame the full IRQ path returns into instead of its own, set by
+// irq_switch_frame() and cleared by vectors.S
+struct irq_frame *irq_next_frame;
+
+#if IRQVEC_STATS
+static const char *path_names[IRQ_PATH_COUNT] = { "leaf", "full", "fallback" };
+#endif
+
+// The vector table, defined in vectors.S
+extern char vectors[];
+
+// SPSR_EL1 for a new context: EL1 using SP_EL1, with nothing masked
+#define SPSR_EL1H           0x5
+
+// Where a context made by irq_frame_init() goes if its entry function
+// returns. There is nothing to go back to, so it stops.
+static void context_exit(void)
+{
+    while (1) {
+        asm volatile("wfe");
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       irqvec_install
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Points VBAR_EL1 at our vector table. Call with IRQs
+//                  masked, after registering the handlers.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void irqvec_install(void)
+{
+    asm volatile("msr vbar_el1, %0\n\tisb" :: "r"(vectors) : "memory");
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       irq_register
+//
+//  Arguments:      irq - IRQ number (see irqvec.h)
+//                  handler - function to call, or 0 to fall back to
+//                            IRQ_handler()
+//                  flags - IRQ_FLAG_LEAF if the handler does not need the
+//                          callee-saved registers, ELR, SPSR, or SP_EL0 in
+//                          its frame, and does not switch contexts
+//
+//  Returns:        void
+//
+//  Description:    Installs a handler for one interrupt source. The handler
+//                  and everything it calls must be marked IRQ_CODE. The source
+//                  must still be enabled at the interrupt controller, and
+//                  the handler must clear it at the peripheral.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void irq_register(unsigned int irq, irq_handler_t handler, unsigned int flags)
+{
+    if (irq >= IRQ_COUNT)
+        return;
+
+    irq_table[irq].flags = flags;
+    irq_table[irq].handler = handler;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       fiq_register
+//
+//  Arguments:      irq - IRQ number of the source to route (see irqvec.h)
+//                  handler - function to call, or 0 to stop routing
+//
+//  Returns:        void
+//
+//  Description:    Sends one interrupt source to FIQ, which preempts IRQ
+//                  handlers, and unmasks FIQ. The source must not also be
+//                  enabled as an IRQ, and the handler, called with a null
+//                  frame, must clear it at the peripheral and be marked
+//                  IRQ_CODE. Call after irqvec_install().
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void fiq_register(unsigned int irq, irq_handler_t handler)
+{
+    if (irq >= IRQ_COUNT)
+        return;
+
+    if (handler == 0) {
+        asm volatile("msr daifset, #1" ::: "memory");
+        *FIQ_CONTROL = 0;
+        fiq_handler = 0;
+        return;
+    }
+
+    fiq_handler = handler;
+    *FIQ_CONTROL = FIQ_ENABLE | irq;
+    asm volatile("msr daifclr, #1" ::: "memory");
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       irq_frame_init
+//
+//  Arguments:      stack_top - end of the new context's stack
+//                  entry - function the context starts in
+//                  arg - argument passed to entry
+//
+//  Returns:        the frame, at the top of the stack
+//
+//  Description:    Builds the frame a new context starts from, for a later
+//                  irq_switch_frame(). The context runs at EL1 with
+//                  interrupts enabled; if entry returns, it stops.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+struct irq_frame *irq_frame_init(void *stack_top, void (*entry)(void *),
+                                 void *arg)
+{
+    struct irq_frame *frame;
+    unsigned int i;
+
+    frame = (struct irq_frame *)(((unsigned long)stack_top & ~0xFUL) -
+                                 sizeof(struct irq_frame));
+    for (i = 0; i < 31; i++)
+        frame->x[i] = 0;
+    frame->x[0] = (unsigned long)arg;
+    frame->x[30] = (unsigned long)context_exit;
+    frame->elr = (unsigned long)entry;
+    frame->spsr = SPSR_EL1H;
+    frame->entry_stamp = 0;
+    frame->call_stamp = 0;
+    frame->sp_el0 = 0;
+
+    return frame;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       irq_switch_frame
+//
+//  Arguments:      next - frame to return into
+//
+//  Returns:        void
+//
+//  Description:    Makes the current interrupt return into next instead of
+//                  the context it interrupted, restoring every register and
+//                  the stack pointer from it. Only for handlers registered
+//                  without IRQ_FLAG_LEAF, which must keep their own frame
+//                  if they want to resume the interrupted context later.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void irq_switch_frame(struct irq_frame *next)
+{
+    irq_next_frame = next;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       irqvec_ticks
+//                  irqvec_tick_rate
+//
+//  Arguments:      none
+//
+//  Returns:        total time spent in interrupt entry paths and handlers,
+//                  in CNTPCT_EL0 ticks / the rate of those ticks in Hz
+//
+//  Description:    Lets task code tell how much of an interval went to
+//                  interrupts. The total is only updated as each interrupt
+//                  returns, and leaves out the final register restore.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned long irqvec_ticks(void)
+{
+    return *(volatile unsigned long *)&irq_total_ticks;
+}
+
+unsigned int irqvec_tick_rate(void)
+{
+    unsigned long rate;
+
+    asm volatile("mrs %0, cntfrq_el0" : "=r"(rate));
+    return rate;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       irqvec_report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Prints the total time spent in IRQs. With IRQVEC_STATS
+//                  it also prints, for each entry path that has run, the
+//                  number of interrupts and the average time per interrupt
+//                  from entry to handler return, inside the handler, and
+//                  the difference: the cost of the path itself. Registering
+//                  the same handlers with and without IRQ_FLAG_LEAF
+//                  compares the two paths. Times are in nanoseconds; one
+//                  counter tick is about 52 ns on the 19.2 MHz BCM2837
+//                  counter, so the averages only settle after many
+//                  interrupts.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void irqvec_report(void)
+{
+    unsigned long rate = irqvec_tick_rate();
+#if IRQVEC_STATS
+    struct irq_path_stats s;
+    unsigned long total_ns, handler_ns;
+    unsigned int i;
+#endif
+
+    if (rate < 1000)
+        return;
+
+    uart_puts("irq:  ");
+    console_putdec(irqvec_ticks() / (rate / 1000));
+    uart_puts(" ms in interrupts\n");
+
+#if IRQVEC_STATS
+    for (i = 0; i < IRQ_PATH_COUNT; i++) {
+        s = *(volatile struct irq_path_stats *)&irq_stats[i];
+        if (s.count == 0)
+            continue;
+
+        // Average thousandths of a tick per IRQ, then nanoseconds
+        total_ns = s.ticks * 1000 / s.count * 1000000 / rate;
+        handler_ns = s.handler_ticks * 1000 / s.count * 1000000 / rate;
+
+        uart_puts("irq ");
+        uart_puts((char *)path_names[i]);
+        uart_puts(":  ");
+        console_putdec(s.count);
+        uart_puts(" irqs  total ");
+        console_putdec(total_ns);
+        uart_puts(" ns  handler ");
+        console_putdec(handler_ns);
+        uart_puts(" ns  entry/exit ");
+        console_putdec(total_ns > handler_ns ? total_ns - handler_ns : 0);
+        uart_puts(" ns\n");
+    }
+#endif
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       unexpected_exception
+//
+//  Arguments:      type - vector table slot (0 - 15)
+//                  esr - ESR_EL1
+//                  elr - ELR_EL1
+//
+//  Returns:        does not return
+//
+//  Description:    Called from every vector other than the current-EL IRQ
+//                  and FIQ entries. Prints what happened and stops.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void unexpected_exception(unsigned long type, unsigned long esr,
+                          unsigned long elr)
+{
+    uart_puts("\nUnexpected exception, vector 0x");
+    uart_puthex(type);
+    uart_puts("  ESR_EL1 0x");
+    uart_puthex(esr);
+    uart_puts("  ELR_EL1 0x");
+    uart_puthex(elr >> 32);
+    uart_puthex(elr);
+    uart_puts("\n");
+
+    while (1) {
+        asm volatile("wfe");
+    }
+}
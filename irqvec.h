@@ -0,0 +1,118 @@
+// Vectored IRQ dispatch. irqvec_install() points VBAR_EL1 at the vector
+// table in vectors.S, whose IRQ entry reads the interrupt controller's
+// pending registers itself and branches straight to the handler registered
+// for the source, with no C dispatcher in between.
+//
+// A handler registered with IRQ_FLAG_LEAF only gets the caller-saved
+// registers (x0 - x18, x30) saved around it, which is all a C function that
+// returns normally needs. Other handlers get the full register set plus
+// ELR_EL1, SPSR_EL1 and SP_EL0 saved in the frame they are passed, and may
+// rewrite any of it. The frame sits at the top of the interrupted stack,
+// so it also records that stack pointer (the frame's address plus its
+// size). Such a handler can switch contexts: it keeps its frame for later
+// and calls irq_switch_frame() with another one, saved the same way or
+// made by irq_frame_init(), and the entry code returns into that one, on
+// its own stack. Sources with no registered handler fall back to
+// IRQ_handler().
+//
+// One source at a time can be sent to FIQ instead with fiq_register().
+// The FIQ entry saves the caller-saved registers and calls its handler
+// (with no frame) without decoding anything. With IRQVEC_NESTED_FIQ (the
+// default) the IRQ entry saves ELR_EL1/SPSR_EL1 and unmasks FIQ while the
+// handler runs, so an FIQ can interrupt IRQ handlers too; that is what
+// lets the profiler sample them.
+//
+// No FP/SIMD registers are saved on either path. Every function that runs
+// in interrupt context must be marked IRQ_CODE so that GCC does not use
+// them (it vectorizes ordinary loops at -O2).
+//
+// The entry reads the generic timer counter (CNTPCT_EL0) once on the way
+// in and once after the handler, and keeps the total time spent in IRQs
+// for irqvec_ticks(). Building with IRQVEC_STATS set to 1 (e.g.
+// -DIRQVEC_STATS=1, for vectors.S and irqvec.c alike) also stamps the
+// handler call and counts each path, with an isb before every read so the
+// split is exact, and irqvec_report() then prints the average cost of each
+// path with and without the handler. That is left out of normal builds,
+// as it costs every interrupt two more counter reads and a stats update.
+//
+// vectors.S includes this file, so everything but the #defines is hidden
+// from the assembler.
+
+#ifndef IRQVEC_H
+#define IRQVEC_H
+
+#ifndef IRQVEC_STATS
+#define IRQVEC_STATS        0
+#endif
+
+#ifndef IRQVEC_NESTED_FIQ
+#define IRQVEC_NESTED_FIQ   1
+#endif
+
+// IRQ numbers 0 - 63 are the GPU interrupts (IRQ_PENDING_1/2); 64 - 71 are
+// the ARM basic interrupts (bits 0 - 7 of IRQ_BASIC_PENDING)
+#define IRQ_SYSTIMER_1      1
+#define IRQ_SYSTIMER_3      3
+#define IRQ_GPIO_ALL        52
+#define IRQ_ARM_TIMER       64
+#define IRQ_COUNT           72
+
+// Handler flags
+#define IRQ_FLAG_LEAF       0x1
+
+// Keeps GCC from using FP/SIMD registers in interrupt context
+#define IRQ_CODE            __attribute__((target("general-regs-only")))
+
+// Entry paths counted by vectors.S with IRQVEC_STATS
+#define IRQ_PATH_LEAF       0
+#define IRQ_PATH_FULL       1
+#define IRQ_PATH_FALLBACK   2
+#define IRQ_PATH_COUNT      3
+
+#ifndef __ASSEMBLER__
+
+// Saved registers. Leaf handlers only get x0 - x18 and x30 filled in.
+// The two stamps are CNTPCT_EL0 at entry and, with IRQVEC_STATS, just
+// before the handler call. 288 bytes, keeping the stack 16-byte aligned.
+struct irq_frame {
+    unsigned long x[31];
+    unsigned long elr;
+    unsigned long spsr;
+    unsigned long entry_stamp;
+    unsigned long call_stamp;
+    unsigned long sp_el0;
+};
+
+// Per-path timing with IRQVEC_STATS, in CNTPCT_EL0 ticks. 32 bytes each,
+// updated by vectors.S.
+struct irq_path_stats {
+    unsigned long count;
+    unsigned long ticks;            // entry to handler return
+    unsigned long handler_ticks;    // inside the handler
+    unsigned long reserved;
+};
+
+typedef void (*irq_handler_t)(struct irq_frame *frame);
+
+struct irq_entry {
+    irq_handler_t handler;
+    unsigned long flags;
+};
+
+extern struct irq_entry irq_table[IRQ_COUNT];
+extern struct irq_path_stats irq_stats[IRQ_PATH_COUNT];
+extern unsigned long irq_total_ticks;
+
+void irqvec_install(void);
+void irq_register(unsigned int irq, irq_handler_t handler, unsigned int flags);
+struct irq_frame *irq_frame_init(void *stack_top, void (*entry)(void *),
+                                 void *arg);
+void irq_switch_frame(struct irq_frame *next);
+void fiq_register(unsigned int irq, irq_handler_t handler);
+unsigned long irqvec_ticks(void);
+unsigned int irqvec_tick_rate(void);
+void irqvec_report(void);
+
+#endif
+
+#endif
@@ -0,0 +1,325 @@
+
+// Header files
+#include "gpio.h"
+#include "irq.h"
+#include "systimer.h"
+#include "pin.h"
+#include "arena.h"
+#include "keypad.h"
+#include "irqvec.h"
+
+// Number of key events that can wait for the main loop
+#define KEYPAD_QUEUE_SIZE       16
+
+// Time for the columns to follow a row that is driven high, and for a
+// row driven low to discharge them again, in microseconds. Both edges
+// are driven, so this does not depend on the column pull-downs (which
+// would take several microseconds to drain a floating column on their
+// own). The system timer only counts whole microseconds, so each wait
+// lasts between this and one more.
+#define KEYPAD_SETTLE_US        2
+
+// Configuration
+unsigned int keypad_col_mask[2];
+static unsigned char col_pin[KEYPAD_MAX_COLS];
+static unsigned int rows;
+static unsigned int cols;
+static unsigned int row_mask[2];
+
+// Where each row's function select field lives, for switching it between
+// output and input during a scan, and its bank and bit in GPSET/GPCLR
+static unsigned char row_fsel[KEYPAD_MAX_ROWS];
+static unsigned char row_shift[KEYPAD_MAX_ROWS];
+static unsigned char row_bank[KEYPAD_MAX_ROWS];
+static unsigned int row_bit[KEYPAD_MAX_ROWS];
+
+// Debounce state, one entry per key
+static unsigned char stable[KEYPAD_MAX_ROWS * KEYPAD_MAX_COLS];
+static unsigned char count[KEYPAD_MAX_ROWS * KEYPAD_MAX_COLS];
+
+// Scan burst state
+static volatile unsigned int scanning;
+static unsigned int idle_scans;
+static unsigned int pressed;
+
+struct eventq keypad_events;
+
+
+// Busy-wait on the system timer for at least us microseconds
+IRQ_CODE static void settle(unsigned int us)
+{
+    unsigned int start = *SYSTIMER_CLO;
+
+    while (*SYSTIMER_CLO - start <= us) {
+        asm volatile("nop");
+    }
+}
+
+// Make one row an output (driven to the level of its output latch) or an
+// input (high impedance)
+IRQ_CODE static void row_drive(unsigned int r, unsigned int on)
+{
+    unsigned int sel = GPFSEL0[row_fsel[r]];
+
+    sel &= ~(0x7u << row_shift[r]);
+    if (on)
+        sel |= PIN_OUTPUT << row_shift[r];
+    GPFSEL0[row_fsel[r]] = sel;
+}
+
+// Set every row's output latch high or low
+IRQ_CODE static void rows_latch(unsigned int high)
+{
+    volatile unsigned int *reg = high ? GPSET0 : GPCLR0;
+
+    if (row_mask[0])
+        reg[0] = row_mask[0];
+    if (row_mask[1])
+        reg[1] = row_mask[1];
+}
+
+// Drive every row high, so a key press on any row raises its column. All
+// rows are at the same level, so keys sharing a column cannot short two
+// rows together.
+IRQ_CODE static void rows_all_high(void)
+{
+    unsigned int r;
+
+    rows_latch(1);
+    for (r = 0; r < rows; r++)
+        row_drive(r, 1);
+}
+
+// Enable or disable rising edge detection on every column
+IRQ_CODE static void columns_detect(unsigned int on)
+{
+    unsigned int bank;
+
+    for (bank = 0; bank < 2; bank++) {
+        if (!keypad_col_mask[bank])
+            continue;
+        if (on) {
+            GPEDS0[bank] = keypad_col_mask[bank];
+            GPREN0[bank] |= keypad_col_mask[bank];
+        } else {
+            GPREN0[bank] &= ~keypad_col_mask[bank];
+        }
+    }
+}
+
+// Nonzero if any column currently reads high
+IRQ_CODE static unsigned int columns_active(void)
+{
+    return (*GPLEV0 & keypad_col_mask[0]) | (GPLEV0[1] & keypad_col_mask[1]);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       keypad_init
+//
+//  Arguments:      row_pins - GPIO pins of the rows (0 - 53)
+//                  row_count - number of rows
+//                  col_pins - GPIO pins of the columns (0 - 53)
+//                  col_count - number of columns
+//
+//  Returns:        1 on success, 0 if the matrix is too large, a pin is out
+//                  of range, or the event queue could not be allocated
+//
+//  Description:    Makes the rows outputs, driven high, and the columns
+//                  pulled-down inputs with rising edge detection, and
+//                  enables the system timer compare 3 interrupt used for
+//                  scanning. The GPIO interrupt must also be enabled, and
+//                  its handler must call keypad_wake() for column edges.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int keypad_init(const unsigned char *row_pins, unsigned int row_count,
+                const unsigned char *col_pins, unsigned int col_count)
+{
+    struct input_event *buf;
+    unsigned int i;
+
+    if (row_count > KEYPAD_MAX_ROWS || col_count > KEYPAD_MAX_COLS)
+        return 0;
+
+    buf = arena_alloc(KEYPAD_QUEUE_SIZE * sizeof(struct input_event),
+                      CACHE_LINE_SIZE);
+    if (buf == 0)
+        return 0;
+    eventq_init(&keypad_events, buf, KEYPAD_QUEUE_SIZE);
+
+    rows = row_count;
+    cols = col_count;
+    row_mask[0] = row_mask[1] = 0;
+    keypad_col_mask[0] = keypad_col_mask[1] = 0;
+
+    for (i = 0; i < rows; i++) {
+        if (row_pins[i] >= PIN_COUNT)
+            return 0;
+        row_fsel[i] = row_pins[i] / 10;
+        row_shift[i] = (row_pins[i] % 10) * 3;
+        row_bank[i] = row_pins[i] / 32;
+        row_bit[i] = 0x1u << (row_pins[i] % 32);
+        row_mask[row_bank[i]] |= row_bit[i];
+    }
+    for (i = 0; i < cols; i++) {
+        if (col_pins[i] >= PIN_COUNT)
+            return 0;
+        col_pin[i] = col_pins[i];
+        keypad_col_mask[col_pins[i] / 32] |= 0x1u << (col_pins[i] % 32);
+        pin_function(col_pins[i], PIN_INPUT);
+    }
+
+    // One pull-up/down clock sequence for each set of pins, both banks
+    pin_pud_apply(PIN_PULL_NONE, row_mask[0], row_mask[1]);
+    pin_pud_apply(PIN_PULL_DOWN, keypad_col_mask[0], keypad_col_mask[1]);
+
+    for (i = 0; i < rows * cols; i++)
+        stable[i] = count[i] = 0;
+
+    scanning = 0;
+    pressed = 0;
+
+    rows_all_high();
+    columns_detect(1);
+
+    // Enable IRQ 3, system timer compare 3
+    *IRQ_ENABLE_IRQS_1 = (0x1 << 3);
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       keypad_wake
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Called from the GPIO interrupt handler when a column
+//                  edge was seen (after GPEDS has been cleared). Turns off
+//                  column edge detection, so the bouncing and the scanning
+//                  itself raise no more interrupts, and starts a scan burst.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void keypad_wake(void)
+{
+    if (scanning)
+        return;
+
+    scanning = 1;
+    idle_scans = 0;
+    columns_detect(0);
+
+    *SYSTIMER_C3 = *SYSTIMER_CLO + KEYPAD_SCAN_US;
+    *SYSTIMER_CS = SYSTIMER_CS_M3;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       keypad_scan_irq
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    System timer compare 3 handler: one scan of the matrix.
+//                  Each row is driven high in turn, with every other row
+//                  floating, and the columns are read. Floating rows and
+//                  columns keep whatever charge they had, and the column
+//                  pull-downs are too weak to drain it within the settle
+//                  time, so a held key would also show up on the next row.
+//                  Every row is therefore driven low together before the
+//                  scan, and each row is driven low again after it has
+//                  been read, before it floats; that empties the columns
+//                  and any rows joined to them through held keys.
+//                  A key changes state once it has read the same for
+//                  KEYPAD_DEBOUNCE_SCANS scans in a row, which queues a
+//                  press or release event. After KEYPAD_IDLE_SCANS scans
+//                  with every key released the burst ends: all rows go
+//                  high again and column edge detection is re-armed.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void keypad_scan_irq(void)
+{
+    unsigned int now;
+    unsigned int levels[2];
+    unsigned int r, c, key, raw, any;
+
+    *SYSTIMER_CS = SYSTIMER_CS_M3;
+    if (!scanning)
+        return;
+
+    now = *SYSTIMER_CLO;
+    any = 0;
+
+    // Pull everything low with all rows at the same level, then float
+    // the rows and drive one at a time. A row is never driven against
+    // another, whichever keys are held.
+    rows_latch(0);
+    settle(KEYPAD_SETTLE_US);
+    for (r = 0; r < rows; r++)
+        row_drive(r, 0);
+
+    for (r = 0; r < rows; r++) {
+        GPSET0[row_bank[r]] = row_bit[r];
+        row_drive(r, 1);
+        settle(KEYPAD_SETTLE_US);
+
+        levels[0] = *GPLEV0;
+        levels[1] = GPLEV0[1];
+
+        // Discharge the columns through this row before letting it float
+        GPCLR0[row_bank[r]] = row_bit[r];
+        settle(KEYPAD_SETTLE_US);
+        row_drive(r, 0);
+
+        for (c = 0; c < cols; c++) {
+            key = r * cols + c;
+            raw = (levels[col_pin[c] / 32] >> (col_pin[c] % 32)) & 0x1;
+            any |= raw;
+
+            // Integrate towards the raw reading
+            if (raw == stable[key]) {
+                count[key] = 0;
+                continue;
+            }
+            if (++count[key] < KEYPAD_DEBOUNCE_SCANS)
+                continue;
+
+            stable[key] = raw;
+            count[key] = 0;
+            pressed += raw ? 1 : -1;
+            eventq_push(&keypad_events, key,
+                        raw ? EDGE_RISING : EDGE_FALLING, now);
+        }
+    }
+
+    rows_all_high();
+
+    // Keep scanning while anything is, or may be, held down
+    idle_scans = (any || pressed) ? 0 : idle_scans + 1;
+    if (idle_scans < KEYPAD_IDLE_SCANS) {
+        *SYSTIMER_C3 = now + KEYPAD_SCAN_US;
+        return;
+    }
+
+    // End the burst. A key pressed while edge detection was off is
+    // already high, so check the levels rather than wait for an edge.
+    columns_detect(1);
+    if (columns_active()) {
+        idle_scans = 0;
+        *SYSTIMER_C3 = now + KEYPAD_SCAN_US;
+        return;
+    }
+    scanning = 0;
+}
@@ -0,0 +1,39 @@
+// Matrix keypad scanner. Rows are outputs and columns are pulled-down
+// inputs, on any pins in either GPIO bank. While idle every row is driven
+// high and a rising edge on any column raises the GPIO interrupt; nothing
+// is polled. The interrupt starts a burst of timer-driven scans (system
+// timer compare 3) that debounces every key and queues press/release
+// events, and ends once all keys have been released for a while, going
+// back to waiting for an edge.
+//
+// Only one row is driven while scanning; the others float, so holding
+// several keys never shorts two outputs together and no diodes are
+// needed for safety. Without diodes, three held keys on the corners of a
+// rectangle make the fourth corner read as pressed too (ghosting).
+
+#ifndef KEYPAD_H
+#define KEYPAD_H
+
+#include "eventq.h"
+
+#define KEYPAD_MAX_ROWS         8
+#define KEYPAD_MAX_COLS         8
+
+// Scan timing
+#define KEYPAD_SCAN_US          1000    // time between scans in a burst
+#define KEYPAD_DEBOUNCE_SCANS   5       // scans a key must be stable for
+#define KEYPAD_IDLE_SCANS       50      // released scans that end a burst
+
+// Column pins, per bank, read by the GPIO interrupt handler
+extern unsigned int keypad_col_mask[2];
+
+// Debounced key events. The pin field holds the key number
+// (row * columns + column); EDGE_RISING is a press, EDGE_FALLING a release.
+extern struct eventq keypad_events;
+
+int keypad_init(const unsigned char *row_pins, unsigned int row_count,
+                const unsigned char *col_pins, unsigned int col_count);
+void keypad_wake(void);
+void keypad_scan_irq(void);
+
+#endif
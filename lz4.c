@@ -0,0 +1,87 @@
+
+// Header files
+#include "lz4.h"
+
+// Minimum match length encoded by a zero in the token
+#define LZ4_MIN_MATCH   4
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       lz4_decompress
+//
+//  Arguments:      src - compressed block
+//                  src_len - size of the compressed block in bytes
+//                  dst - where to write the decompressed data
+//                  dst_cap - space available at dst
+//
+//  Returns:        number of bytes written, or -1 if the block is corrupt
+//
+//  Description:    Decodes an LZ4 block directly into its destination. Every
+//                  length and offset is checked against both buffers, so a
+//                  damaged transfer cannot write outside dst.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int lz4_decompress(const unsigned char *src, unsigned int src_len,
+                   unsigned char *dst, unsigned int dst_cap)
+{
+    const unsigned char *ip = src;
+    const unsigned char *iend = src + src_len;
+    unsigned char *op = dst;
+    unsigned char *oend = dst + dst_cap;
+    const unsigned char *match;
+    unsigned int token, len, offset, b;
+
+    while (ip < iend) {
+        token = *ip++;
+
+        // Literal run, with 255-byte length extensions
+        len = token >> 4;
+        if (len == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        if (len > (unsigned int)(iend - ip) || len > (unsigned int)(oend - op))
+            return -1;
+        while (len--)
+            *op++ = *ip++;
+
+        // The last sequence has literals only
+        if (ip >= iend)
+            break;
+
+        // Match: 16-bit little-endian offset back into the output
+        if (iend - ip < 2)
+            return -1;
+        offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        if (offset == 0 || offset > (unsigned int)(op - dst))
+            return -1;
+        match = op - offset;
+
+        len = token & 0xF;
+        if (len == 15) {
+            do {
+                if (ip >= iend)
+                    return -1;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += LZ4_MIN_MATCH;
+        if (len > (unsigned int)(oend - op))
+            return -1;
+
+        // Byte by byte, since the match may overlap what it produces
+        while (len--)
+            *op++ = *match++;
+    }
+
+    return op - dst;
+}
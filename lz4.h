@@ -0,0 +1,11 @@
+// LZ4 block format decompressor (no frame header; sizes are carried by the
+// chainloader protocol instead).
+// See https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+
+#ifndef LZ4_H
+#define LZ4_H
+
+int lz4_decompress(const unsigned char *src, unsigned int src_len,
+                   unsigned char *dst, unsigned int dst_cap);
+
+#endif
@@ -1,14 +1,30 @@
-// This program sets up GPIO pin 17 as an input pin, and sets it to generate
-// an interrupt whenever a rising edge is detected. The pin is assumed to
-// be connected to a push button switch on a breadboard. When the button is
-// pushed, a 3.3V level will be applied to the pin. The pin should otherwise
-// be pulled low with a pull-down resistor of 10K Ohms.
+// This program sets up GPIO pins 23 and 24 as input pins, and sets them to
+// generate an interrupt whenever a rising (23) or falling (24) edge is
+// detected, and drives LEDs on GPIO pins 17, 27, and 22. Each input pin is
+// assumed to be connected to a push button switch on a breadboard. When the
+// button is pushed, a 3.3V level will be applied to the pin. The pin should
+// otherwise be pulled low with a pull-down resistor of 10K Ohms.
 
 // Include files
 #include "uart.h"
 #include "sysreg.h"
 #include "gpio.h"
 #include "irq.h"
+#include "pin.h"
+
+// Pin assignments
+#define LED1_PIN    17
+#define LED2_PIN    27
+#define LED3_PIN    22
+#define BUTTON1_PIN 23
+#define BUTTON2_PIN 24
+
+// Pin configurations
+#define LED1_PINS(X, a)     X(a, LED1_PIN, PIN_OUTPUT, PIN_PULL_NONE, PIN_EDGE_NONE)
+#define LED2_PINS(X, a)     X(a, LED2_PIN, PIN_OUTPUT, PIN_PULL_NONE, PIN_EDGE_NONE)
+#define LED3_PINS(X, a)     X(a, LED3_PIN, PIN_OUTPUT, PIN_PULL_NONE, PIN_EDGE_NONE)
+#define BUTTON1_PINS(X, a)  X(a, BUTTON1_PIN, PIN_INPUT, PIN_PULL_NONE, PIN_EDGE_RISING)
+#define BUTTON2_PINS(X, a)  X(a, BUTTON2_PIN, PIN_INPUT, PIN_PULL_NONE, PIN_EDGE_FALLING)
 
 
 // Function prototypes
@@ -41,8 +57,8 @@ unsigned int mode;
 //
 //  Description:    This function first prints out the values of some system
 //                  registers for diagnostic purposes. It then initializes
-//                  GPIO pin 17 to be an input pin that generates an interrupt
-//                  (IRQ exception) whenever a rising edge occurs on the pin.
+//                  GPIO pins 23 and 24 to be input pins that generate an
+//                  interrupt (IRQ exception) whenever an edge occurs on the pin.
 //                  The function then goes into an infinite loop, where the
 //                  shared global variable is continually checked. If the
 //                  interrupt service routine changes the shared variable,
@@ -103,8 +119,8 @@ void main()
     localValue = 0;
     mode = 0;
 
-    // Set up GPIO pin #17 to input and so that it triggers
-    // an interrupt when a rising edge is detected
+    // Set up GPIO pins #23 and #24 as inputs that trigger
+    // interrupts, and the LED pins as outputs
     init_GPIO23_to_risingEdgeInterrupt();
     init_GPIO24_to_fallingEdgeInterrupt();
     init_GPIO17_to_output();
@@ -160,34 +176,22 @@ void main()
     }
 }
 void setLED1(){
-  register unsigned int r;
-  r = (0x1 << 17);
-  *GPSET0 = r;
+  PIN_SET(LED1_PIN);
 }
 void clearLED1(){
-  register unsigned int r;
-  r = (0x1 << 17);
-  *GPCLR0 = r;
+  PIN_CLEAR(LED1_PIN);
 }
 void setLED2(){
-  register unsigned int r;
-  r = (0x1 << 27);
-  *GPSET0 = r;
+  PIN_SET(LED2_PIN);
 }
 void clearLED2(){
-  register unsigned int r;
-  r = (0x1 << 27);
-  *GPCLR0 = r;
+  PIN_CLEAR(LED2_PIN);
 }
 void setLED3(){
-  register unsigned int r;
-  r = (0x1 << 22);
-  *GPSET0 = r;
+  PIN_SET(LED3_PIN);
 }
 void clearLED3(){
-  register unsigned int r;
-  r = (0x1 << 22);
-  *GPCLR0 = r;
+  PIN_CLEAR(LED3_PIN);
 }
 void blinkLED(){
   if(mode == 0){
@@ -242,18 +246,18 @@ void longWait(){
 
 ////////////////////////////////////////////////////////////////////////////////
 //
-//  Function:       init_GPIO17_to_risingEdgeInterrupt
+//  Function:       init_GPIO23_to_risingEdgeInterrupt
 //
 //  Arguments:      none
 //
 //  Returns:        void
 //
-//  Description:    This function sets GPIO pin 17 to an input pin without
+//  Description:    This function sets GPIO pin 23 to an input pin without
 //                  any internal pull-up or pull-down resistors. Note that
 //                  a pull-down (or pull-up) resistor must be used externally
 //                  on the bread board circuit connected to the pin. Be sure
 //                  that the pin high level is 3.3V (definitely NOT 5V).
-//                  GPIO pin 17 is also set to trigger an interrupt on a
+//                  GPIO pin 23 is also set to trigger an interrupt on a
 //                  rising edge, and GPIO interrupts are enabled on the
 //                  interrupt controller.
 //
@@ -261,267 +265,67 @@ void longWait(){
 
 void init_GPIO23_to_risingEdgeInterrupt()
 {
-    register unsigned int r;
-
-
-    // Get the current contents of the GPIO Function Select Register 1
-    r = *GPFSEL2;
-
-    // Clear bits 21 - 23. This is the field FSEL17, which maps to GPIO pin 17.
-    // We clear the bits by ANDing with a 000 bit pattern in the field. This
-    // sets the pin to be an input pin
-    r &= ~(0x7 << 9);
-
-    // Write the modified bit pattern back to the
-    // GPIO Function Select Register 1
-    *GPFSEL2 = r;
-
-    // Disable the pull-up/pull-down control line for GPIO pin 17. We follow the
-    // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. We
-    // will pull down the pin using an external resistor connected to ground.
-
-    // Disable internal pull-up/pull-down by setting bits 0:1
-    // to 00 in the GPIO Pull-Up/Down Register
-    *GPPUD = 0x0;
-
-    // Wait 150 cycles to provide the required set-up time
-    // for the control signal
-    r = 150;
-    while (r--) {
-        asm volatile("nop");
-    }
-
-    // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 17 to
-    // clock in the control signal for GPIO pin 17. Note that all other pins
-    // will retain their previous state.
-    *GPPUDCLK0 = (0x1 << 23);
-
-    // Wait 150 cycles to provide the required hold time
-    // for the control signal
-    r = 150;
-    while (r--) {
-        asm volatile("nop");
-    }
-
-    // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
-    // in order to remove the clock
-    *GPPUDCLK0 = 0;
-
-    // Set pin 17 to so that it generates an interrupt on a rising edge.
-    // We do so by setting bit 17 in the GPIO Rising Edge Detect Enable
-    // Register 0 to a 1 value (p. 97 in the Broadcom manual).
-    *GPREN0 = (0x1 << 23);
+    // Set FSEL23 to input, clock "no pull" into pin 23, and set bit 23 in
+    // the GPIO Rising Edge Detect Enable Register 0 (p. 97 in the
+    // Broadcom manual)
+    pin_group_init(BUTTON1_PINS);
 
     // Enable the GPIO IRQS for ALL the GPIO pins by setting IRQ 52
     // GPIO_int[3] in the Interrupt Enable Register 2 to a 1 value.
     // See p. 117 in the Broadcom Peripherals Manual.
     *IRQ_ENABLE_IRQS_2 = (0x1 << 20);
 }
-void init_GPIO24_to_fallingEdgeInterrupt()
-{
-    register unsigned int r;
-
-
-    // Get the current contents of the GPIO Function Select Register 1
-    r = *GPFSEL2;
-
-    // Clear bits 21 - 23. This is the field FSEL17, which maps to GPIO pin 17.
-    // We clear the bits by ANDing with a 000 bit pattern in the field. This
-    // sets the pin to be an input pin
-    r &= ~(0x7 << 12);
 
-    // Write the modified bit pattern back to the
-    // GPIO Function Select Register 1
-    *GPFSEL2 = r;
 
-    // Disable the pull-up/pull-down control line for GPIO pin 17. We follow the
-    // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. We
-    // will pull down the pin using an external resistor connected to ground.
-
-    // Disable internal pull-up/pull-down by setting bits 0:1
-    // to 00 in the GPIO Pull-Up/Down Register
-    *GPPUD = 0x0;
-
-    // Wait 150 cycles to provide the required set-up time
-    // for the control signal
-    r = 150;
-    while (r--) {
-        asm volatile("nop");
-    }
-
-    // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 17 to
-    // clock in the control signal for GPIO pin 17. Note that all other pins
-    // will retain their previous state.
-    *GPPUDCLK0 = (0x1 << 24);
-
-    // Wait 150 cycles to provide the required hold time
-    // for the control signal
-    r = 150;
-    while (r--) {
-        asm volatile("nop");
-    }
-
-    // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
-    // in order to remove the clock
-    *GPPUDCLK0 = 0;
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       init_GPIO24_to_fallingEdgeInterrupt
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    This function sets GPIO pin 24 to an input pin without
+//                  any internal pull-up or pull-down resistors, and sets it
+//                  to trigger an interrupt on a falling edge. GPIO
+//                  interrupts are enabled on the interrupt controller.
+//
+////////////////////////////////////////////////////////////////////////////////
 
-    // Set pin 17 to so that it generates an interrupt on a rising edge.
-    // We do so by setting bit 17 in the GPIO Rising Edge Detect Enable
-    // Register 0 to a 1 value (p. 97 in the Broadcom manual).
-    *GPREN0 = (0x1 << 23);
+void init_GPIO24_to_fallingEdgeInterrupt()
+{
+    // Set FSEL24 to input, clock "no pull" into pin 24, and set bit 24 in
+    // the GPIO Falling Edge Detect Enable Register 0
+    pin_group_init(BUTTON2_PINS);
 
     // Enable the GPIO IRQS for ALL the GPIO pins by setting IRQ 52
     // GPIO_int[3] in the Interrupt Enable Register 2 to a 1 value.
-    // See p. 117 in the Broadcom Peripherals Manual.
     *IRQ_ENABLE_IRQS_2 = (0x1 << 20);
 }
-void init_GPIO17_to_output(){
-  register unsigned int r;
-
-
-  // Get the current contents of the GPIO Function Select Register 2
-  r = *GPFSEL1;
-
-  // Clear bits 9 - 11. This is the field FSEL23, which maps to GPIO pin 23.
-  // We clear the bits by ANDing with a 000 bit pattern in the field.
-  r &= ~(0x7 << 21);
-
-  // Set the field FSEL23 to 001, which sets pin 23 to an output pin.
-  // We do so by ORing the bit pattern 001 into the field.
-  r |= (0x1 << 21);
 
-  // Write the modified bit pattern back to the
-  // GPIO Function Select Register 2
-  *GPFSEL1 = r;
 
-  // Disable the pull-up/pull-down control line for GPIO pin 23. We follow the
-  // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. The
-  // internal pull-up and pull-down resistor isn't needed for an output pin.
-
-  // Disable pull-up/pull-down by setting bits 0:1
-  // to 00 in the GPIO Pull-Up/Down Register
-  *GPPUD = 0x0;
-
-  // Wait 150 cycles to provide the required set-up time
-  // for the control signal
-  r = 150;
-  while (r--) {
-    asm volatile("nop");
-  }
-
-  // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 23 to
-  // clock in the control signal for GPIO pin 23. Note that all other pins
-  // will retain their previous state.
-  *GPPUDCLK0 = (0x1 << 17);
-
-  // Wait 150 cycles to provide the required hold time
-  // for the control signal
-  r = 150;
-  while (r--) {
-    asm volatile("nop");
-  }
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       init_GPIO17_to_output
+//                  init_GPIO22_to_output
+//                  init_GPIO27_to_output
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    These functions set GPIO pins 17, 22, and 27 to output
+//                  pins and disable their internal pull-up/pull-down
+//                  resistors, which aren't needed for an output pin.
+//
+////////////////////////////////////////////////////////////////////////////////
 
-  // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
-  // in order to remove the clock
-  *GPPUDCLK0 = 0;
+void init_GPIO17_to_output(){
+  pin_group_init(LED1_PINS);
 }
 void init_GPIO22_to_output(){
-  register unsigned int r;
-
-
-  // Get the current contents of the GPIO Function Select Register 2
-  r = *GPFSEL2;
-
-  // Clear bits 9 - 11. This is the field FSEL23, which maps to GPIO pin 23.
-  // We clear the bits by ANDing with a 000 bit pattern in the field.
-  r &= ~(0x7 << 6);
-
-  // Set the field FSEL23 to 001, which sets pin 23 to an output pin.
-  // We do so by ORing the bit pattern 001 into the field.
-  r |= (0x1 << 6);
-
-  // Write the modified bit pattern back to the
-  // GPIO Function Select Register 2
-  *GPFSEL2 = r;
-
-  // Disable the pull-up/pull-down control line for GPIO pin 23. We follow the
-  // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. The
-  // internal pull-up and pull-down resistor isn't needed for an output pin.
-
-  // Disable pull-up/pull-down by setting bits 0:1
-  // to 00 in the GPIO Pull-Up/Down Register
-  *GPPUD = 0x0;
-
-  // Wait 150 cycles to provide the required set-up time
-  // for the control signal
-  r = 150;
-  while (r--) {
-    asm volatile("nop");
-  }
-
-  // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 23 to
-  // clock in the control signal for GPIO pin 23. Note that all other pins
-  // will retain their previous state.
-  *GPPUDCLK0 = (0x1 << 22);
-
-  // Wait 150 cycles to provide the required hold time
-  // for the control signal
-  r = 150;
-  while (r--) {
-    asm volatile("nop");
-  }
-
-  // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
-  // in order to remove the clock
-  *GPPUDCLK0 = 0;
+  pin_group_init(LED3_PINS);
 }
 void init_GPIO27_to_output(){
-  register unsigned int r;
-
-
-  // Get the current contents of the GPIO Function Select Register 2
-  r = *GPFSEL2;
-
-  // Clear bits 9 - 11. This is the field FSEL23, which maps to GPIO pin 23.
-  // We clear the bits by ANDing with a 000 bit pattern in the field.
-  r &= ~(0x7 << 21);
-
-  // Set the field FSEL23 to 001, which sets pin 23 to an output pin.
-  // We do so by ORing the bit pattern 001 into the field.
-  r |= (0x1 << 21);
-
-  // Write the modified bit pattern back to the
-  // GPIO Function Select Register 2
-  *GPFSEL2 = r;
-
-  // Disable the pull-up/pull-down control line for GPIO pin 23. We follow the
-  // procedure outlined on page 101 of the BCM2837 ARM Peripherals manual. The
-  // internal pull-up and pull-down resistor isn't needed for an output pin.
-
-  // Disable pull-up/pull-down by setting bits 0:1
-  // to 00 in the GPIO Pull-Up/Down Register
-  *GPPUD = 0x0;
-
-  // Wait 150 cycles to provide the required set-up time
-  // for the control signal
-  r = 150;
-  while (r--) {
-    asm volatile("nop");
-  }
-
-  // Write to the GPIO Pull-Up/Down Clock Register 0, using a 1 on bit 23 to
-  // clock in the control signal for GPIO pin 23. Note that all other pins
-  // will retain their previous state.
-  *GPPUDCLK0 = (0x1 << 27);
-
-  // Wait 150 cycles to provide the required hold time
-  // for the control signal
-  r = 150;
-  while (r--) {
-    asm volatile("nop");
-  }
-
-  // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
-  // in order to remove the clock
-  *GPPUDCLK0 = 0;
+  pin_group_init(LED2_PINS);
 }
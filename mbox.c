@@ -0,0 +1,221 @@
+
+// Header files
+#include "gpio.h"
+#include "mbox.h"
+
+// Mailbox 0 registers (ARM side)
+#define VIDEOCORE_MBOX  (MMIO_BASE + 0x0000B880)
+#define MBOX_READ       ((volatile unsigned int *)(VIDEOCORE_MBOX + 0x00))
+#define MBOX_STATUS     ((volatile unsigned int *)(VIDEOCORE_MBOX + 0x18))
+#define MBOX_WRITE      ((volatile unsigned int *)(VIDEOCORE_MBOX + 0x20))
+#define MBOX_FULL       0x80000000
+#define MBOX_EMPTY      0x40000000
+
+// Size of the message buffer, in words
+#define MBOX_WORDS      36
+
+// The message buffer. The low 4 bits of its address carry the channel
+// number, so it must be 16-byte aligned.
+static volatile unsigned int __attribute__((aligned(16))) mbox[MBOX_WORDS];
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mbox_call
+//
+//  Arguments:      channel - mailbox channel to post the buffer on
+//
+//  Returns:        1 if the firmware answered with a success code, 0 if not
+//
+//  Description:    Posts the message buffer to the VideoCore and waits for
+//                  the reply to the same buffer on the same channel.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int mbox_call(unsigned char channel)
+{
+    register unsigned int r;
+
+    // Combine the buffer address with the channel number
+    r = (unsigned int)((unsigned long)&mbox & ~0xF) | (channel & 0xF);
+
+    // Wait until we can write to the mailbox, then post the message
+    while (*MBOX_STATUS & MBOX_FULL) {
+        asm volatile("nop");
+    }
+    *MBOX_WRITE = r;
+
+    // Wait for the response to our message
+    while (1) {
+        while (*MBOX_STATUS & MBOX_EMPTY) {
+            asm volatile("nop");
+        }
+        if (*MBOX_READ == r)
+            return mbox[1] == MBOX_RESPONSE;
+    }
+}
+
+
+// Send a single property tag with the given value words, and copy the
+// response values back. Returns 0 if the call or the tag failed.
+static int mbox_property(unsigned int tag, unsigned int *values,
+                         unsigned int count)
+{
+    unsigned int i;
+
+    mbox[0] = (count + 6) * 4;      // total buffer size in bytes
+    mbox[1] = MBOX_REQUEST;
+    mbox[2] = tag;
+    mbox[3] = count * 4;            // value buffer size in bytes
+    mbox[4] = 0;                    // request
+    for (i = 0; i < count; i++)
+        mbox[5 + i] = values[i];
+    mbox[5 + count] = MBOX_TAG_LAST;
+
+    if (!mbox_call(MBOX_CH_PROP) || !(mbox[4] & MBOX_RESPONSE))
+        return 0;
+
+    for (i = 0; i < count; i++)
+        values[i] = mbox[5 + i];
+
+    return 1;
+}
+
+// Most queries send an id and get back the id and a value
+static unsigned int mbox_get_value(unsigned int tag, unsigned int id)
+{
+    unsigned int values[2];
+
+    values[0] = id;
+    values[1] = 0;
+    if (!mbox_property(tag, values, 2))
+        return 0;
+
+    return values[1];
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mbox_get_clock_rate
+//                  mbox_get_measured_clock_rate
+//                  mbox_get_max_clock_rate
+//                  mbox_get_min_clock_rate
+//
+//  Arguments:      clock_id - MBOX_CLOCK_ARM, MBOX_CLOCK_CORE, ...
+//
+//  Returns:        the rate in Hz, or 0 if the query failed
+//
+//  Description:    The plain rate is the one last requested; the measured
+//                  rate is what the clock is actually running at, which can
+//                  be lower while the firmware is throttling.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int mbox_get_clock_rate(unsigned int clock_id)
+{
+    return mbox_get_value(MBOX_TAG_GETCLKRATE, clock_id);
+}
+
+unsigned int mbox_get_measured_clock_rate(unsigned int clock_id)
+{
+    return mbox_get_value(MBOX_TAG_GETMEASURED, clock_id);
+}
+
+unsigned int mbox_get_max_clock_rate(unsigned int clock_id)
+{
+    return mbox_get_value(MBOX_TAG_GETMAXCLKRATE, clock_id);
+}
+
+unsigned int mbox_get_min_clock_rate(unsigned int clock_id)
+{
+    return mbox_get_value(MBOX_TAG_GETMINCLKRATE, clock_id);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mbox_set_clock_rate
+//
+//  Arguments:      clock_id - MBOX_CLOCK_ARM, MBOX_CLOCK_CORE, ...
+//                  rate - requested rate in Hz
+//
+//  Returns:        the rate the firmware actually set, or 0 on failure
+//
+//  Description:    Asks the firmware to change a clock. skip_setting_turbo
+//                  is set, so asking for the maximum ARM rate does not also
+//                  switch on turbo, which would raise the core clock that
+//                  the mini UART baud rate, the SPI0 divider, and the ARM
+//                  timer prescaler are all derived from.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int mbox_set_clock_rate(unsigned int clock_id, unsigned int rate)
+{
+    unsigned int values[3];
+
+    values[0] = clock_id;
+    values[1] = rate;
+    values[2] = 1;
+    if (!mbox_property(MBOX_TAG_SETCLKRATE, values, 3))
+        return 0;
+
+    return values[1];
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mbox_get_temperature
+//                  mbox_get_max_temperature
+//
+//  Arguments:      none
+//
+//  Returns:        SoC temperature in thousandths of a degree Celsius, or 0
+//
+//  Description:    The maximum is the temperature at which the firmware
+//                  starts throttling, so the difference between the two is
+//                  the thermal headroom.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int mbox_get_temperature(void)
+{
+    return mbox_get_value(MBOX_TAG_GETTEMP, 0);
+}
+
+unsigned int mbox_get_max_temperature(void)
+{
+    return mbox_get_value(MBOX_TAG_GETMAXTEMP, 0);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       mbox_get_throttled
+//
+//  Arguments:      none
+//
+//  Returns:        the throttled flags (MBOX_THROTTLED_*); the same flags
+//                  shifted left 16 bits record conditions seen since boot
+//
+//  Description:    Reports under-voltage, frequency capping, and thermal
+//                  throttling.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+unsigned int mbox_get_throttled(void)
+{
+    unsigned int values[1];
+
+    values[0] = 0;
+    if (!mbox_property(MBOX_TAG_GETTHROTTLED, values, 1))
+        return 0;
+
+    return values[0];
+}
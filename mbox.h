@@ -0,0 +1,47 @@
+// VideoCore mailbox property interface. Requests are built in a 16-byte
+// aligned buffer whose address is posted on the property channel; the
+// firmware writes its responses back into the same buffer.
+// See https://github.com/raspberrypi/firmware/wiki/Mailbox-property-interface
+
+#ifndef MBOX_H
+#define MBOX_H
+
+// Channels
+#define MBOX_CH_PROP            8
+
+// Request/response codes
+#define MBOX_REQUEST            0x00000000
+#define MBOX_RESPONSE           0x80000000
+
+// Property tags
+#define MBOX_TAG_GETTEMP        0x00030006
+#define MBOX_TAG_GETMAXTEMP     0x0003000A
+#define MBOX_TAG_GETCLKRATE     0x00030002
+#define MBOX_TAG_GETMEASURED    0x00030047
+#define MBOX_TAG_GETMAXCLKRATE  0x00030004
+#define MBOX_TAG_GETMINCLKRATE  0x00030007
+#define MBOX_TAG_SETCLKRATE     0x00038002
+#define MBOX_TAG_GETTHROTTLED   0x00030046
+#define MBOX_TAG_LAST           0x00000000
+
+// Clock ids
+#define MBOX_CLOCK_ARM          3
+#define MBOX_CLOCK_CORE         4
+
+// Bits in the throttled flags
+#define MBOX_THROTTLED_UNDERVOLT    (0x1 << 0)
+#define MBOX_THROTTLED_CAPPED       (0x1 << 1)
+#define MBOX_THROTTLED_NOW          (0x1 << 2)
+#define MBOX_THROTTLED_SOFT_TEMP    (0x1 << 3)
+
+int mbox_call(unsigned char channel);
+unsigned int mbox_get_clock_rate(unsigned int clock_id);
+unsigned int mbox_get_measured_clock_rate(unsigned int clock_id);
+unsigned int mbox_get_max_clock_rate(unsigned int clock_id);
+unsigned int mbox_get_min_clock_rate(unsigned int clock_id);
+unsigned int mbox_set_clock_rate(unsigned int clock_id, unsigned int rate);
+unsigned int mbox_get_temperature(void);
+unsigned int mbox_get_max_temperature(void);
+unsigned int mbox_get_throttled(void);
+
+#endif
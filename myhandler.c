@@ -1,78 +1,177 @@
-
-// Header files
-#include "uart.h"
-#include "gpio.h"
-#include "irq.h"
-#include "sysreg.h"
-
-// Reference to the global mode of operation variable
-extern unsigned int mode;
-
-
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Function:       IRQ_handler
-//
-//  Arguments:      none
-//
-//  Returns:        void
-//
-//  Description:    This function first prints out some basic information about
-//                  the state of the interrupt controller, GPIO pending
-//                  interrupts, and selected system registers. Determines if interrupt is
-//                  coming from pin 23 or pin 24. The interrupt is cleared, 
-//                  and interrupt is handled to transition to the correct mode.
-//
-////////////////////////////////////////////////////////////////////////////////
-
-void IRQ_handler()
-{
-    unsigned int r;
-
-    // Print out exception type
-    uart_puts("\nInside IRQ exception handler:\n");
-
-    // Print out further information about the exception    
-    r = getCurrentEL();
-    uart_puts("    CurrentEL is:  0x");
-    uart_puthex(r);
-    uart_puts("\n");
-
-    r = getDAIF();
-    uart_puts("    DAIF is:  0x");
-    uart_puthex(r);
-    uart_puts("\n");
-
-    r = *IRQ_PENDING_2;
-    uart_puts("    IRQ_PENDING_2 is:  0x");
-    uart_puthex(r);
-    uart_puts("\n");
-    
-    r = *GPEDS0;
-    uart_puts("    GPEDS0 is:  0x");
-    uart_puthex(r);
-    uart_puts("\n");
-    	
-
-    // Handle GPIO interrupts in general
-    if (*IRQ_PENDING_2 == 0x00100000) {
-      // Handle the interrupt associated with GPIO pin 23
-      if (*GPEDS0 == 0x00020000) {          // !!!!------ must update this number
-	   // Clear the interrupt
-	   *GPEDS0 = (0x1 << 23); 
-	   // change the mode
-	   mode = 0;
-      }
-
-      //Handle interrupt associated with GPIO pin 24
-      if (*GPEDS0 == 0x00040000) {         // !!!------- must update this number
-        //Clear the interrupt
-        *GPEDS0 = (0x1 <<24);
-        //change the mode
-        mode = 1;
-      }
-    } 
-    
-    // Return to the IRQ exception handler stub
-    return;
-}
\ No newline at end of file
+
+// Header files
+#include "gpio.h"
+#include "irq.h"
+#include "systimer.h"
+#include "eventq.h"
+#include "edgecount.h"
+#include "keypad.h"
+#include "profile.h"
+#include "irqvec.h"
+
+// Reference to the global input event queue
+extern struct eventq input_events;
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       gpio_irq
+//
+//  Arguments:      frame - saved registers (unused, this is a leaf handler)
+//
+//  Returns:        void
+//
+//  Description:    Edges on pins owned by the edge counter are handed to it
+//                  as one batch. A rising edge on any keypad column, in
+//                  either bank, wakes the keypad scanner. Every other
+//                  pending bank 0 edge is recorded
+//                  as a {pin, edge, timestamp} event in the input event
+//                  queue. All of them are cleared with one write. Nothing is
+//                  decided here: the gesture recognizer and sequencer in the
+//                  main loop interpret the events, so the time spent in the
+//                  handler stays small and constant however rich the controls
+//                  become. The edge direction is taken from the pin level at
+//                  the time of the interrupt.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void gpio_irq(struct irq_frame *frame)
+{
+    register unsigned int pending;
+    register unsigned int levels;
+    register unsigned int now;
+    register unsigned int pin;
+    register unsigned int pending1;
+    register unsigned int counted;
+
+    (void)frame;
+
+    // Take one timestamp and one level snapshot for the whole batch
+    now = *SYSTIMER_CLO;
+    pending = *GPEDS0;
+    pending1 = GPEDS0[1];
+    levels = *GPLEV0;
+
+    // Clear every edge we are about to record in a single write per bank.
+    // Bank 1 edges only come from keypad columns.
+    *GPEDS0 = pending;
+    if (pending1)
+        GPEDS0[1] = pending1;
+
+    // A key went down: the keypad takes over with a timed scan burst
+    if ((pending & keypad_col_mask[0]) | (pending1 & keypad_col_mask[1]))
+        keypad_wake();
+    pending &= ~keypad_col_mask[0];
+
+    // Let the edge counter absorb its pins' edges in one call
+    counted = pending & edgecount_mask;
+    if (counted) {
+        edgecount_gpio_irq(counted, levels);
+        pending &= ~counted;
+    }
+
+    // Queue one event per pin that saw an edge
+    while (pending) {
+        pin = __builtin_ctz(pending);
+        eventq_push(&input_events, pin, (levels >> pin) & 0x1, now);
+        pending &= pending - 1;
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       systimer1_irq
+//
+//  Arguments:      frame - saved registers (unused, this is a leaf handler)
+//
+//  Returns:        void
+//
+//  Description:    System timer compare 1 belongs to the edge counter.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void systimer1_irq(struct irq_frame *frame)
+{
+    (void)frame;
+
+    edgecount_timer_irq();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       systimer3_irq
+//
+//  Arguments:      frame - saved registers (unused, this is a leaf handler)
+//
+//  Returns:        void
+//
+//  Description:    System timer compare 3 paces the keypad scan bursts.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void systimer3_irq(struct irq_frame *frame)
+{
+    (void)frame;
+
+    keypad_scan_irq();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       armtimer_irq
+//
+//  Arguments:      frame - null, this is the FIQ handler
+//
+//  Returns:        void
+//
+//  Description:    The ARM timer drives the sampling profiler. It is routed
+//                  to FIQ so that samples also land in IRQ handlers.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void armtimer_irq(struct irq_frame *frame)
+{
+    (void)frame;
+
+    profile_sample();
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       IRQ_handler
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Dispatcher used for any interrupt source without a
+//                  handler registered in the vector table (and by the
+//                  original exception stub). Checks each source we use
+//                  and calls its handler.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void IRQ_handler()
+{
+    // Handle the edge counter's sample / hold-off timer (IRQ 1)
+    if (*IRQ_PENDING_1 & (0x1 << 1)) {
+        systimer1_irq(0);
+    }
+
+    // Handle the keypad scan timer (IRQ 3)
+    if (*IRQ_PENDING_1 & (0x1 << 3)) {
+        systimer3_irq(0);
+    }
+
+    // Handle GPIO interrupts in general (IRQ 52, GPIO_int[3])
+    if (*IRQ_PENDING_2 & (0x1 << 20)) {
+        gpio_irq(0);
+    }
+
+    // Return to the IRQ exception handler stub
+    return;
+}
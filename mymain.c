@@ -1,236 +1,513 @@
-// This program sets up GPIO pins 17, 27, 22 as output pins, 
-// and pins 23 and 24 to input pins (buttons)
-// generates interrupts when a button is pushed on the breadboard.
-// Button A will put the program into mode 0 (state 1)
-// Button B will put the program into mode 1 (state 2)
-
-// Include files
-#include "uart.h"
-#include "sysreg.h"
-#include "gpio.h"
-#include "irq.h"
-
-
-// Function prototypes
-void init_pins();
-void change_light(int mode);
-void smallWait();
-void stateOne();
-void stateTwo();
-void stateThree();
-
-// Declare a global mode of operation
-unsigned int mode;
-unsigned int state;
-
-
-
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Function:       main
-//
-//  Arguments:      none
-//
-//  Returns:        void
-//
-//  Description:    Initialize global mode value, enable all the pins,
-//                  then infinitely loop through the LED's and change
-//                  mode depending on interrupts.
-//
-////////////////////////////////////////////////////////////////////////////////
-
-void main()
-{
-    unsigned int r;
-    unsigned int localValue;
-
-    // Set up the UART serial port
-    uart_init();
-
-    // Initialize the mode global variable and
-    // and set the local variable to be same value
-    localValue = mode = 0;
-    state = 1;
-    
-    // Setup pins to be inputs and outputs
-    init_pins();
-    
-    // Enable IRQ Exceptions
-    enableIRQ();
-
-    // Loop forever, waiting for interrupts to change the shared value
-    while (1) {
-    // Check to see if the mode was changed by an interrupt
-	if (localValue != mode) {
-	    // Update the local variable
-	    localValue = mode;
-        }
-	    // change which light emits
-        change_light(mode);
-
-        // Delay a little using a busy loop
-       longWait();
-    }
-}
-
-
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Function:       change_light
-//
-//  Arguments:      mode - 0 for lights to go in order 1,2,3 .. 1 for lights to 
-//                  go in order 3,2,1
-//
-//  Returns:        void
-//
-//  Description:    If mode = 0, will change next light to emit, all others off
-//                  If mode = 1, change the previous light to emit, all others off
-//
-////////////////////////////////////////////////////////////////////////////////
-
-void change_light(int mode){
-    if (mode == 0){
-        longWait();     // make it take longer to iterate if it is in mode 0
-        if(state == 1){
-            //if mode = 0, and LED1 is on, turn LED1 off, and turn LED2 on
-            stateTwo();
-        } else if(state == 2){
-             //if mode = 0, and LED2 is on, turn LED2 off, and turn LED3 on
-            stateThree();
-        } else if(state == 3){
-            //if mode = 0, and LED3 is on, turn LED3 off, and turn LED1 on
-            stateOne();
-        }
-    } else if(mode == 1) {
-        if(state == 1){
-            //if mode = 1, and LED1 is on, turn LED1 off, and turn LED3 on
-            stateThree();
-        } else if(state == 2){
-            //if mode = 1, and LED2 is on, turn LED2 off, and turn LED1 on
-            stateOne(state == 3);
-        } else if(){
-             //if mode = 1, and LED3 is on, turn LED3 off, and turn LED2 on
-            stateTwo();
-        }
-    }
-}
-
-
-// A sequence of state changing functions for the LED lights
-void stateOne(){
-    state = 1;
-    register unsigned int r;
-    r = (0x1 << 17);    //light up LED connected to pin 17
-    *GPSET0 = r;
-    r = (0x1 << 22);
-    *GPCLR0 = r;
-    r = (0x1 << 27);
-    *GPCLR0 = r;
-}
-void stateTwo(){
-    state = 2;
-    r = (0x1 << 17);    
-    *GPCLR0 = r;
-    r = (0x1 << 22);
-    *GPCLR0 = r;
-    r = (0x1 << 27);    //light up LED connected to pin 27
-    *GPSET0 = r;
-}
-void stateThree(){
-    state = 3;
-     r = (0x1 << 17);    
-    *GPCLR0 = r;
-    r = (0x1 << 22);    //light up LED connected to pin 27
-    *GPSET0 = r;
-    r = (0x1 << 27); 
-    *GPCLR0 = r;
-}
-
-////////////////////////////////////////////////////////////////////////////////
-//
-//  Function:       init_pins
-//
-//  Arguments:      none
-//
-//  Returns:        void
-//
-//  Description:    Set pins 17, 27, 22 to output
-//                  Set pins 23, 24 to input
-//
-////////////////////////////////////////////////////////////////////////////////
-
-void init_pins()
-{
-    register unsigned int r;
-    register unsigned int s;
-    
-    
-    // Get the current contents of the GPIO Function Select Register 1
-    r = *GPFSEL1;
-    // Get contents of GPFSEL2
-    s = *GPFSEL2;
-
-    //clear all bits corresponding to our input/output pins
-    r &= ~(0x7 << 21);      // pin 17
-    s &= ~(0x7 << 6);       // pin 22
-    s &= ~(0x7 << 9);       // pin 23
-    s &= ~(0x7 << 12);      // pin 24
-    s &= ~(0x7 << 21);      // pin 27
-
-    //set appropriate pins to output (others are already 000 which is input)
-    r |= (0x1 << 21);       // pin 17 to output
-    s |= (0x1 << 6);        // pin 22 to output
-    s |= (0x1 << 21);       // pin 27 to output
-
-    // Write the modified bit patterns back to the registers
-    *GPFSEL1 = r;
-    *GPFSEL2 = s;
-
-    // Disable internal pull-up/pull-down by setting bits 0:1
-    // to 00 in the GPIO Pull-Up/Down Register 
-    *GPPUD = 0x0;
-
-    // Wait 150 cycles to provide the required set-up time 
-    smallWait();
-    // Write to the GPIO Pull-Up/Down Clock Register 0
-    *GPPUDCLK0 = (0x1 << 17);
-    // Wait 150 cycles to provide the required hold time
-    smallWait();
-    // Repeat process for each other pin.
-    *GPPUDCLK0 = (0x1 << 22);
-    smallWait();
-    *GPPUDCLK0 = (0x1 << 23);
-    smallWait();
-    *GPPUDCLK0 = (0x1 << 24);
-    smallWait();
-    *GPPUDCLK0 = (0x1 << 27);
-    smallWait();
-
-    // Clear all bits in the GPIO Pull-Up/Down Clock Register 0
-    *GPPUDCLK0 = 0;
-    
-    // Set pin 23 to falling edge triggered interrupt
-    *GPFEN0 = (0x1 << 23);
-    // Set pin 24 to rising edge triggered interrupt
-    *GPREN0 = (0x1 << 24);
-    
-    // Enable the GPIO IRQS for ALL the GPIO pins 
-    *IRQ_ENABLE_IRQS_2 = (0x1 << 20);
-}
-
-
-// a small waiting subroutine 
-void smallWait(){
-    r = 150;
-    while (r--) {
-        asm volatile("nop");
-    }
-}
-
-// a longer waiting subroutine
-void longWait(){
-    r = 0x0005FFFF;
-    while (r--) {
-        asm volatile("nop");
-    }
-}
+// This program sets up GPIO pins 17, 27, 22 as output pins, 
+// and pins 23 and 24 to input pins (buttons)
+// generates interrupts when a button is pushed on the breadboard.
+// Button A will put the program into mode 0 (state 1)
+// Button B will put the program into mode 1 (state 2)
+// A 4x4 keypad on GPIO 16/19/20/21 (rows) and 12/18/25/26 (columns)
+// gives the same controls from its letter, * and # keys.
+
+// Include files
+#include "uart.h"
+#include "sysreg.h"
+#include "gpio.h"
+#include "irq.h"
+#include "systimer.h"
+#include "eventq.h"
+#include "gesture.h"
+#include "arena.h"
+#include "pin.h"
+#include "governor.h"
+#include "spiled.h"
+#include "edgecount.h"
+#include "irqvec.h"
+#include "keypad.h"
+#include "profile.h"
+
+// Pin assignments
+#define LED1_PIN                17
+#define LED2_PIN                27
+#define LED3_PIN                22
+#define BUTTON_A                23
+#define BUTTON_B                24
+
+// The LEDs are plain outputs. The buttons use external pull-down resistors
+// and interrupt on both edges, so presses (rising) and releases (falling)
+// both reach the gesture recognizer.
+#define LED_PINS(X, a)                                                  \
+    X(a, LED1_PIN, PIN_OUTPUT, PIN_PULL_NONE, PIN_EDGE_NONE)            \
+    X(a, LED2_PIN, PIN_OUTPUT, PIN_PULL_NONE, PIN_EDGE_NONE)            \
+    X(a, LED3_PIN, PIN_OUTPUT, PIN_PULL_NONE, PIN_EDGE_NONE)
+#define BUTTON_PINS(X, a)                                               \
+    X(a, BUTTON_A, PIN_INPUT, PIN_PULL_NONE, PIN_EDGE_BOTH)             \
+    X(a, BUTTON_B, PIN_INPUT, PIN_PULL_NONE, PIN_EDGE_BOTH)
+#define APP_PINS(X, a)          LED_PINS(X, a) BUTTON_PINS(X, a)
+
+// LED output. With SPI_LED_COUNT set to 0 the sequencer drives the three
+// LEDs on GPIO 17/27/22 directly; otherwise it runs the same sequence over
+// that many LEDs chained on SPI0, refreshed with one DMA transfer per step.
+#define SPI_LED_COUNT           0
+#define SPI_LED_TYPE            SPILED_SHIFT_REGISTER
+#define SPI_LED_CLOCK_DIV       64          // 250 MHz core clock / 64
+#define SPI_LED_COLOUR          0x00FF00
+
+// Fast inputs handled by the edge counter: a rotary encoder on GPIO 5/6
+// and a tachometer or pulse counter on GPIO 13. The sample period must be
+// shorter than the time between edges on any one pin.
+#define ENCODER_A_PIN           5
+#define ENCODER_B_PIN           6
+#define PULSE_PIN               13
+#define EDGECOUNT_METHOD        EDGECOUNT_SAMPLED
+#define EDGECOUNT_PERIOD_US     100
+
+// 4x4 matrix keypad. Rows and columns may be on either GPIO bank; the
+// columns use the internal pull-downs.
+#define KEYPAD_ROW_PINS         { 16, 19, 20, 21 }
+#define KEYPAD_COL_PINS         { 12, 18, 25, 26 }
+#define KEYPAD_KEYS             "123A456B789C*0#D"
+
+// Sampling profiler rate, in samples per second (0 to leave it out). Kept
+// off multiples of the 1 ms keypad scan and the step periods so samples do
+// not alias with them. The chord gesture or # key dumps the profile.
+#define PROFILE_RATE_HZ         997
+
+// The state functions drive the LEDs through the bank 0 registers
+_Static_assert(PIN_GROUP_BITS(LED_PINS, 1) == 0, "LEDs must be on pins 0 - 31");
+
+// Sequencer step period limits, in microseconds
+#define STEP_PERIOD_DEFAULT     200000
+#define STEP_PERIOD_MIN         25000
+#define STEP_PERIOD_MAX         1600000
+
+// Number of input events the IRQ handler can queue ahead of the main loop
+#define INPUT_EVENT_QUEUE_SIZE  32
+
+// Entry path for the interrupt handlers. Set to 0 to run them all through
+// the full register save and, in a build with IRQVEC_STATS (irqvec.h),
+// compare the "irq" lines of the report.
+#define IRQ_HANDLER_FLAGS       IRQ_FLAG_LEAF
+
+
+// Function prototypes
+void init_pins();
+void change_light(int mode);
+void handle_gesture(struct gesture *g);
+void gpio_irq(struct irq_frame *frame);
+void systimer1_irq(struct irq_frame *frame);
+void systimer3_irq(struct irq_frame *frame);
+void handle_key(struct input_event *ev);
+void report();
+void armtimer_irq(struct irq_frame *frame);
+void stateOne();
+void stateTwo();
+void stateThree();
+
+// Declare a global mode of operation
+unsigned int mode;
+unsigned int state;
+unsigned int paused;
+unsigned int step_period;
+
+// Declare the queue the IRQ handler pushes input events into
+struct eventq input_events;
+
+// Keypad wiring, and the legend of each key in scan order
+static const unsigned char keypad_rows[] = KEYPAD_ROW_PINS;
+static const unsigned char keypad_cols[] = KEYPAD_COL_PINS;
+static const char keypad_keys[] = KEYPAD_KEYS;
+
+_Static_assert(sizeof(keypad_keys) - 1 == sizeof(keypad_rows) * sizeof(keypad_cols),
+               "KEYPAD_KEYS needs one legend per key");
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       main
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Initialize global mode value, enable all the pins,
+//                  then infinitely loop through the LED's. Input events
+//                  queued by the IRQ handler are drained on every pass and
+//                  turned into gestures, which change the mode, speed, or
+//                  pause the sequence. The LEDs advance whenever the step
+//                  period has elapsed on the system timer. Each pass tells
+//                  the clock governor whether it did any work.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void main()
+{
+    unsigned int now;
+    unsigned int last_step;
+    unsigned int busy;
+    struct input_event ev;
+    struct input_event *events;
+    struct gesture g;
+
+    // Set up the UART serial port
+    uart_init();
+
+    // Initialize the mode global variables
+    mode = 0;
+    state = 1;
+    paused = 0;
+    step_period = STEP_PERIOD_DEFAULT;
+
+    // Set up the input event queue and the gesture recognizer before
+    // any interrupt can push to the queue. The queue storage comes from
+    // the arena, on its own cache line, and recognized gestures from a
+    // pool. Without them there is nothing to run, so stop here.
+    events = arena_alloc(INPUT_EVENT_QUEUE_SIZE * sizeof(struct input_event),
+                         CACHE_LINE_SIZE);
+    if (events == 0 || !gesture_init(PIN_GROUP_BITS(BUTTON_PINS, 0))) {
+        uart_puts("out of arena memory\n");
+        pool_report_all();
+        while (1) {
+            asm volatile("wfe");
+        }
+    }
+    eventq_init(&input_events, events, INPUT_EVENT_QUEUE_SIZE);
+
+    // Print out how much of the arena initialization used
+    pool_report_all();
+
+    // Setup pins to be inputs and outputs
+    init_pins();
+
+    // Set up the edge counter's pins before interrupts are enabled
+    edgecount_init(EDGECOUNT_METHOD, EDGECOUNT_PERIOD_US);
+    edgecount_add_encoder(ENCODER_A_PIN, ENCODER_B_PIN, PIN_PULL_UP);
+    edgecount_add_pin(PULSE_PIN, PIN_PULL_DOWN);
+    edgecount_start();
+
+    // Set up the keypad; it sleeps until a column edge wakes it
+    if (!keypad_init(keypad_rows, sizeof(keypad_rows),
+                     keypad_cols, sizeof(keypad_cols)))
+        uart_puts("keypad: bad configuration\n");
+
+#if SPI_LED_COUNT
+    // Set up the SPI LED chain with the first LED lit. The frames come
+    // from the arena too, and the sequencer has nothing to show without
+    // them.
+    if (!spiled_init(SPI_LED_TYPE, SPI_LED_COUNT, SPI_LED_CLOCK_DIV)) {
+        uart_puts("out of arena memory\n");
+        pool_report_all();
+        while (1) {
+            asm volatile("wfe");
+        }
+    }
+    spiled_set(0, SPI_LED_COLOUR);
+    spiled_show();
+#endif
+
+    // Send the GPIO, edge counter, and keypad timer interrupts straight
+    // from the vector table to their handlers, saving only caller-saved
+    // registers
+    irq_register(IRQ_GPIO_ALL, gpio_irq, IRQ_HANDLER_FLAGS);
+    irq_register(IRQ_SYSTIMER_1, systimer1_irq, IRQ_HANDLER_FLAGS);
+    irq_register(IRQ_SYSTIMER_3, systimer3_irq, IRQ_HANDLER_FLAGS);
+    irqvec_install();
+#if PROFILE_RATE_HZ
+    // The profiler's timer goes to FIQ, so it can sample IRQ handlers too
+    profile_init(PROFILE_RATE_HZ);
+    fiq_register(IRQ_ARM_TIMER, armtimer_irq);
+#endif
+
+    // Enable IRQ Exceptions
+    enableIRQ();
+
+    last_step = *SYSTIMER_CLO;
+
+    // Start the ARM clock governor and print the clock and temperature
+    governor_init(last_step);
+
+#if PROFILE_RATE_HZ
+    // Profile everything from here on
+    profile_start();
+#endif
+
+    // Loop forever, consuming input events and stepping the sequence
+    while (1) {
+        now = *SYSTIMER_CLO;
+
+        busy = 0;
+
+        // Feed queued edges to the recognizer and act on what it finds
+        while (eventq_pop(&input_events, &ev)) {
+            gesture_feed(&ev);
+            busy = 1;
+        }
+        while (gesture_poll(now, &g)) {
+            handle_gesture(&g);
+            busy = 1;
+        }
+
+        // Act on debounced keypad presses
+        while (eventq_pop(&keypad_events, &ev)) {
+            handle_key(&ev);
+            busy = 1;
+        }
+
+        // Change which light emits once the step period has elapsed.
+        // Mode 0 steps at half the rate of mode 1.
+        if (!paused && now - last_step >= (mode == 0 ? 2 : 1) * step_period) {
+            last_step = now;
+            change_light(mode);
+            busy = 1;
+        }
+
+        // Refresh the edge rates once a second
+        edgecount_update(now);
+
+        // Let the governor see how much of the time was spent idling
+        governor_account(*SYSTIMER_CLO, busy);
+    }
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       handle_gesture
+//
+//  Arguments:      g - a gesture from the recognizer
+//
+//  Returns:        void
+//
+//  Description:    Maps button gestures onto the sequencer:
+//                    short press A  - mode 0 (lights go 1,2,3)
+//                    short press B  - mode 1 (lights go 3,2,1)
+//                    long press A   - speed up
+//                    long press B   - slow down
+//                    double press   - pause / resume
+//                    A+B chord      - reset speed and resume, and print
+//                                     the clock, temperature, edge
+//                                     counts, and profile
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void handle_gesture(struct gesture *g)
+{
+    switch (g->type) {
+    case GESTURE_SHORT_PRESS:
+        mode = (g->pins == PIN_BIT(BUTTON_A)) ? 0 : 1;
+        uart_puts("\nmode is:  ");
+        uart_puthex(mode);
+        break;
+
+    case GESTURE_LONG_PRESS:
+        if (g->pins == PIN_BIT(BUTTON_A)) {
+            if (step_period > STEP_PERIOD_MIN)
+                step_period >>= 1;
+        } else {
+            if (step_period < STEP_PERIOD_MAX)
+                step_period <<= 1;
+        }
+        uart_puts("\nstep period is:  ");
+        uart_puthex(step_period);
+        break;
+
+    case GESTURE_DOUBLE_PRESS:
+        paused = !paused;
+        uart_puts(paused ? "\npaused" : "\nresumed");
+        break;
+
+    case GESTURE_CHORD:
+        step_period = STEP_PERIOD_DEFAULT;
+        paused = 0;
+        uart_puts("\nreset\n");
+        report();
+        break;
+    }
+    uart_puts("\n");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       handle_key
+//
+//  Arguments:      ev - a debounced keypad event
+//
+//  Returns:        void
+//
+//  Description:    Echoes each key press and maps the letter keys onto the
+//                  same controls as the button gestures:
+//                    A - mode 0          B - mode 1
+//                    C - speed up        D - slow down
+//                    * - pause / resume  # - reset and report
+//                  Releases are ignored.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void handle_key(struct input_event *ev)
+{
+    char key;
+
+    if (ev->edge != EDGE_RISING)
+        return;
+
+    key = keypad_keys[ev->pin];
+    uart_puts("\nkey:  ");
+    uart_send(key);
+
+    switch (key) {
+    case 'A':
+    case 'B':
+        mode = (key == 'A') ? 0 : 1;
+        break;
+
+    case 'C':
+        if (step_period > STEP_PERIOD_MIN)
+            step_period >>= 1;
+        break;
+
+    case 'D':
+        if (step_period < STEP_PERIOD_MAX)
+            step_period <<= 1;
+        break;
+
+    case '*':
+        paused = !paused;
+        break;
+
+    case '#':
+        step_period = STEP_PERIOD_DEFAULT;
+        paused = 0;
+        uart_puts("\n");
+        report();
+        break;
+    }
+    uart_puts("\n");
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       report
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Prints the clock governor state, interrupt entry costs,
+//                  edge counts, and arena and pool usage, then dumps the
+//                  profile collected since the last report and starts a
+//                  new one.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void report()
+{
+    governor_report();
+    irqvec_report();
+    edgecount_report();
+    pool_report_all();
+
+#if PROFILE_RATE_HZ
+    profile_stop();
+    profile_dump();
+    profile_reset();
+    profile_start();
+#endif
+}
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       change_light
+//
+//  Arguments:      mode - 0 for lights to go in order 1,2,3 .. 1 for lights to 
+//                  go in order 3,2,1
+//
+//  Returns:        void
+//
+//  Description:    If mode = 0, will change next light to emit, all others off
+//                  If mode = 1, change the previous light to emit, all others off
+//                  On an SPI chain the same applies to lights 1 .. SPI_LED_COUNT.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void change_light(int mode){
+#if SPI_LED_COUNT
+    if (mode == 0)
+        state = state % SPI_LED_COUNT + 1;
+    else
+        state = (state == 1) ? SPI_LED_COUNT : state - 1;
+
+    // Redraw the back frame and send the whole chain in one DMA transfer
+    spiled_clear();
+    spiled_set(state - 1, SPI_LED_COLOUR);
+    spiled_show();
+#else
+    if (mode == 0){
+        if(state == 1){
+            //if mode = 0, and LED1 is on, turn LED1 off, and turn LED2 on
+            stateTwo();
+        } else if(state == 2){
+             //if mode = 0, and LED2 is on, turn LED2 off, and turn LED3 on
+            stateThree();
+        } else if(state == 3){
+            //if mode = 0, and LED3 is on, turn LED3 off, and turn LED1 on
+            stateOne();
+        }
+    } else if(mode == 1) {
+        if(state == 1){
+            //if mode = 1, and LED1 is on, turn LED1 off, and turn LED3 on
+            stateThree();
+        } else if(state == 2){
+            //if mode = 1, and LED2 is on, turn LED2 off, and turn LED1 on
+            stateOne();
+        } else if(state == 3){
+             //if mode = 1, and LED3 is on, turn LED3 off, and turn LED2 on
+            stateTwo();
+        }
+    }
+#endif
+}
+
+
+// A sequence of state changing functions for the LED lights. Each one
+// lights its LED with one GPSET0 write and turns the others off with one
+// GPCLR0 write.
+void stateOne(){
+    state = 1;
+    *GPCLR0 = PIN_GROUP_BITS(LED_PINS, 0) & ~PIN_BIT(LED1_PIN);
+    PIN_SET(LED1_PIN);      //light up LED connected to pin 17
+}
+void stateTwo(){
+    state = 2;
+    *GPCLR0 = PIN_GROUP_BITS(LED_PINS, 0) & ~PIN_BIT(LED2_PIN);
+    PIN_SET(LED2_PIN);      //light up LED connected to pin 27
+}
+void stateThree(){
+    state = 3;
+    *GPCLR0 = PIN_GROUP_BITS(LED_PINS, 0) & ~PIN_BIT(LED3_PIN);
+    PIN_SET(LED3_PIN);      //light up LED connected to pin 22
+}
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       init_pins
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Set pins 17, 27, 22 to output
+//                  Set pins 23, 24 to input, interrupting on both edges
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void init_pins()
+{
+    // Configure every pin with one read-modify-write of GPFSEL1 and
+    // GPFSEL2, a single pull-up/down clock sequence, and one write each
+    // to GPREN0 and GPFEN0
+    pin_group_init(APP_PINS);
+
+    // Enable the GPIO IRQS for ALL the GPIO pins 
+    *IRQ_ENABLE_IRQS_2 = (0x1 << 20);
+}
@@ -0,0 +1,214 @@
+// Compile-time GPIO pin configuration. Every register index, shift, and bit
+// is computed from the pin number by the compiler, so no magic numbers need
+// to be kept in sync by hand and constant pins compile down to the same
+// loads and stores as hand-written MMIO.
+//
+// A pin group is an X-macro list with one X(a, pin, mode, pull, edge) entry
+// per pin, for example:
+//
+//     #define LED_PINS(X, a)  X(a, 17, PIN_OUTPUT, PIN_PULL_NONE, PIN_EDGE_NONE)
+//
+// pin_group_init(LED_PINS) then configures the whole group with one
+// read-modify-write per function select register actually used, one
+// pull-up/down sequence per pull setting, and one write per edge register.
+// Out-of-range pins, modes, or pulls, and edge detection on a pin that is
+// not an input, are compile errors.
+
+#ifndef PIN_H
+#define PIN_H
+
+#include "gpio.h"
+
+// Number of GPIO pins on the BCM2837
+#define PIN_COUNT           54
+
+// Function select values (p. 92 in the Broadcom manual)
+#define PIN_INPUT           0x0
+#define PIN_OUTPUT          0x1
+#define PIN_ALT0            0x4
+#define PIN_ALT1            0x5
+#define PIN_ALT2            0x6
+#define PIN_ALT3            0x7
+#define PIN_ALT4            0x3
+#define PIN_ALT5            0x2
+
+// Pull-up/down control values for GPPUD
+#define PIN_PULL_NONE       0x0
+#define PIN_PULL_DOWN       0x1
+#define PIN_PULL_UP         0x2
+
+// Edge detection
+#define PIN_EDGE_NONE       0x0
+#define PIN_EDGE_RISING     0x1
+#define PIN_EDGE_FALLING    0x2
+#define PIN_EDGE_BOTH       (PIN_EDGE_RISING | PIN_EDGE_FALLING)
+
+
+// Fails to compile if n is not a valid pin number, otherwise evaluates to n
+#define PIN_CHECKED(n)      ((n) + 0 * sizeof(char[(n) >= 0 && (n) < PIN_COUNT ? 1 : -1]))
+
+// Where pin n lives in the register file
+#define PIN_BANK(n)         (PIN_CHECKED(n) / 32)
+#define PIN_BIT(n)          (0x1u << (PIN_CHECKED(n) % 32))
+#define PIN_FSEL_INDEX(n)   (PIN_CHECKED(n) / 10)
+#define PIN_FSEL_SHIFT(n)   ((PIN_CHECKED(n) % 10) * 3)
+
+// Bank 1 registers directly follow their bank 0 counterparts
+#define PIN_FSEL_REG(n)     (GPFSEL0 + PIN_FSEL_INDEX(n))
+#define PIN_SET_REG(n)      (GPSET0 + PIN_BANK(n))
+#define PIN_CLR_REG(n)      (GPCLR0 + PIN_BANK(n))
+#define PIN_LEV_REG(n)      (GPLEV0 + PIN_BANK(n))
+#define PIN_EDS_REG(n)      (GPEDS0 + PIN_BANK(n))
+#define PIN_REN_REG(n)      (GPREN0 + PIN_BANK(n))
+#define PIN_FEN_REG(n)      (GPFEN0 + PIN_BANK(n))
+#define PIN_PUDCLK_REG(n)   (GPPUDCLK0 + PIN_BANK(n))
+
+// Single pin output and input
+#define PIN_SET(n)          (*PIN_SET_REG(n) = PIN_BIT(n))
+#define PIN_CLEAR(n)        (*PIN_CLR_REG(n) = PIN_BIT(n))
+#define PIN_READ(n)         ((*PIN_LEV_REG(n) & PIN_BIT(n)) != 0)
+
+
+// X-macro helpers. Each expands one group entry into a term of an OR (or
+// AND) expression that only contributes when the pin matches the selector.
+#define PIN_X_VALID(sel, n, mode, pull, edge)                                  \
+    && ((n) >= 0 && (n) < PIN_COUNT && (mode) >= 0 && (mode) <= 7 &&           \
+        (pull) >= 0 && (pull) <= 2 && (edge) >= 0 && (edge) <= 3 &&            \
+        ((edge) == PIN_EDGE_NONE || (mode) == PIN_INPUT))
+#define PIN_X_BIT(bank, n, mode, pull, edge)                                   \
+    | ((n) / 32 == (bank) ? 0x1u << ((n) % 32) : 0u)
+#define PIN_X_FSEL_MASK(reg, n, mode, pull, edge)                              \
+    | ((n) / 10 == (reg) ? 0x7u << (((n) % 10) * 3) : 0u)
+#define PIN_X_FSEL_VAL(reg, n, mode, pull, edge)                               \
+    | ((n) / 10 == (reg) ? (unsigned int)(mode) << (((n) % 10) * 3) : 0u)
+#define PIN_X_PULL_BIT(bank_pull, n, mode, pull, edge)                         \
+    | (((n) / 32) * 4 + (pull) == (bank_pull) ? 0x1u << ((n) % 32) : 0u)
+#define PIN_X_REN_BIT(bank, n, mode, pull, edge)                               \
+    | ((n) / 32 == (bank) && ((edge) & PIN_EDGE_RISING) ? 0x1u << ((n) % 32) : 0u)
+#define PIN_X_FEN_BIT(bank, n, mode, pull, edge)                               \
+    | ((n) / 32 == (bank) && ((edge) & PIN_EDGE_FALLING) ? 0x1u << ((n) % 32) : 0u)
+
+// Group-wide constants
+#define PIN_GROUP_VALID(list)           (1 list(PIN_X_VALID, 0))
+#define PIN_GROUP_BITS(list, bank)      (0u list(PIN_X_BIT, bank))
+#define PIN_GROUP_FSEL_MASK(list, reg)  (0u list(PIN_X_FSEL_MASK, reg))
+#define PIN_GROUP_FSEL_VAL(list, reg)   (0u list(PIN_X_FSEL_VAL, reg))
+#define PIN_GROUP_PULL_BITS(list, bank, pull) (0u list(PIN_X_PULL_BIT, (bank) * 4 + (pull)))
+#define PIN_GROUP_REN_BITS(list, bank)  (0u list(PIN_X_REN_BIT, bank))
+#define PIN_GROUP_FEN_BITS(list, bank)  (0u list(PIN_X_FEN_BIT, bank))
+
+
+// Wait the 150 cycles of set-up/hold time the pull-up/down clock needs
+static inline void pin_pud_wait(void)
+{
+    register unsigned int r;
+
+    r = 150;
+    while (r--) {
+        asm volatile("nop");
+    }
+}
+
+// One read-modify-write of GPFSELn; vanishes when the mask is constant 0
+static inline void pin_fsel_update(unsigned int reg, unsigned int mask,
+                                   unsigned int val)
+{
+    if (mask)
+        GPFSEL0[reg] = (GPFSEL0[reg] & ~mask) | val;
+}
+
+// Set bits in a read-modify-write register; vanishes when bits is 0
+static inline void pin_reg_or(volatile unsigned int *reg, unsigned int bits)
+{
+    if (bits)
+        *reg |= bits;
+}
+
+// Clock one pull setting into every pin in both banks' masks, following the
+// procedure on p. 101 of the BCM2837 ARM Peripherals manual
+static inline void pin_pud_apply(unsigned int pull, unsigned int bits0,
+                                 unsigned int bits1)
+{
+    if (!(bits0 | bits1))
+        return;
+
+    *GPPUD = pull;
+    pin_pud_wait();
+    if (bits0)
+        *GPPUDCLK0 = bits0;
+    if (bits1)
+        GPPUDCLK0[1] = bits1;
+    pin_pud_wait();
+    *GPPUD = 0;
+    if (bits0)
+        *GPPUDCLK0 = 0;
+    if (bits1)
+        GPPUDCLK0[1] = 0;
+}
+
+// Run-time counterparts of the group operations, for pins that come from a
+// table or an API argument rather than a constant
+static inline void pin_function(unsigned int n, unsigned int mode)
+{
+    pin_fsel_update(n / 10, 0x7u << ((n % 10) * 3), mode << ((n % 10) * 3));
+}
+
+static inline void pin_pull(unsigned int n, unsigned int pull)
+{
+    if (n / 32)
+        pin_pud_apply(pull, 0, 0x1u << (n % 32));
+    else
+        pin_pud_apply(pull, 0x1u << (n % 32), 0);
+}
+
+static inline void pin_edge(unsigned int n, unsigned int edge)
+{
+    unsigned int bank = n / 32;
+    unsigned int bit = 0x1u << (n % 32);
+
+    if (edge & PIN_EDGE_RISING)
+        GPREN0[bank] |= bit;
+    else
+        GPREN0[bank] &= ~bit;
+    if (edge & PIN_EDGE_FALLING)
+        GPFEN0[bank] |= bit;
+    else
+        GPFEN0[bank] &= ~bit;
+}
+
+// Configure every pin in a group: function, pull, and edge detection
+#define pin_group_init(list)                                                   \
+    do {                                                                       \
+        _Static_assert(PIN_GROUP_VALID(list), "invalid pin configuration in " #list); \
+        pin_fsel_update(0, PIN_GROUP_FSEL_MASK(list, 0), PIN_GROUP_FSEL_VAL(list, 0)); \
+        pin_fsel_update(1, PIN_GROUP_FSEL_MASK(list, 1), PIN_GROUP_FSEL_VAL(list, 1)); \
+        pin_fsel_update(2, PIN_GROUP_FSEL_MASK(list, 2), PIN_GROUP_FSEL_VAL(list, 2)); \
+        pin_fsel_update(3, PIN_GROUP_FSEL_MASK(list, 3), PIN_GROUP_FSEL_VAL(list, 3)); \
+        pin_fsel_update(4, PIN_GROUP_FSEL_MASK(list, 4), PIN_GROUP_FSEL_VAL(list, 4)); \
+        pin_fsel_update(5, PIN_GROUP_FSEL_MASK(list, 5), PIN_GROUP_FSEL_VAL(list, 5)); \
+        pin_pud_apply(PIN_PULL_NONE, PIN_GROUP_PULL_BITS(list, 0, PIN_PULL_NONE), \
+                      PIN_GROUP_PULL_BITS(list, 1, PIN_PULL_NONE));            \
+        pin_pud_apply(PIN_PULL_DOWN, PIN_GROUP_PULL_BITS(list, 0, PIN_PULL_DOWN), \
+                      PIN_GROUP_PULL_BITS(list, 1, PIN_PULL_DOWN));            \
+        pin_pud_apply(PIN_PULL_UP, PIN_GROUP_PULL_BITS(list, 0, PIN_PULL_UP),  \
+                      PIN_GROUP_PULL_BITS(list, 1, PIN_PULL_UP));              \
+        pin_reg_or(GPREN0, PIN_GROUP_REN_BITS(list, 0));                       \
+        pin_reg_or(GPREN0 + 1, PIN_GROUP_REN_BITS(list, 1));                   \
+        pin_reg_or(GPFEN0, PIN_GROUP_FEN_BITS(list, 0));                       \
+        pin_reg_or(GPFEN0 + 1, PIN_GROUP_FEN_BITS(list, 1));                   \
+    } while (0)
+
+// Drive every pin in a group high or low with one write per bank
+#define pin_group_set(list)                                                    \
+    do {                                                                       \
+        if (PIN_GROUP_BITS(list, 0)) *GPSET0 = PIN_GROUP_BITS(list, 0);       \
+        if (PIN_GROUP_BITS(list, 1)) GPSET0[1] = PIN_GROUP_BITS(list, 1);     \
+    } while (0)
+
+#define pin_group_clear(list)                                                  \
+    do {                                                                       \
+        if (PIN_GROUP_BITS(list, 0)) *GPCLR0 = PIN_GROUP_BITS(list, 0);       \
+        if (PIN_GROUP_BITS(list, 1)) GPCLR0[1] = PIN_GROUP_BITS(list, 1);     \
+    } while (0)
+
+#endif
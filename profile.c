@@ -0,0 +1,218 @@
+
+// Header files
+#include "uart.h"
+#include "gpio.h"
+#include "systimer.h"
+#include "console.h"
+#include "profile.h"
+#include "irqvec.h"
+
+// ARM timer (SP804) registers
+#define ARM_TIMER_LOAD      ((volatile unsigned int *)(MMIO_BASE + 0x0000B400))
+#define ARM_TIMER_VALUE     ((volatile unsigned int *)(MMIO_BASE + 0x0000B404))
+#define ARM_TIMER_CONTROL   ((volatile unsigned int *)(MMIO_BASE + 0x0000B408))
+#define ARM_TIMER_IRQ_CLR   ((volatile unsigned int *)(MMIO_BASE + 0x0000B40C))
+#define ARM_TIMER_RELOAD    ((volatile unsigned int *)(MMIO_BASE + 0x0000B418))
+#define ARM_TIMER_PREDIV    ((volatile unsigned int *)(MMIO_BASE + 0x0000B41C))
+
+// Control register bits
+#define ARM_TIMER_32BIT     (0x1 << 1)
+#define ARM_TIMER_IRQ_EN    (0x1 << 5)
+#define ARM_TIMER_ENABLE    (0x1 << 7)
+
+// The timer runs from the 250 MHz APB clock; divide it down to 1 MHz.
+// The firmware may move the core clock, so the dump also reports the
+// sampling time measured on the system timer.
+#define ARM_TIMER_CLOCK     250000000
+#define ARM_TIMER_TICK_HZ   1000000
+
+// End of the code, from the linker script. Code is all PCs can point to,
+// so the buckets only need to cover .text, not the data and .bss after it
+// (which hold the arena and the histogram itself). If the linker script
+// does not define _etext the whole image up to _end is covered instead,
+// with wider buckets.
+extern char _etext[] __attribute__((weak));
+extern char _end[];
+
+// Histogram, indexed by (address - PROFILE_BASE) >> shift
+static unsigned int buckets[PROFILE_BUCKETS];
+static unsigned int shift;
+static volatile unsigned int samples;
+static volatile unsigned int outside;
+
+// Sampling time, in system timer microseconds
+static unsigned int period_us;
+static unsigned int running;
+static unsigned int started;
+static unsigned int elapsed;
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_init
+//
+//  Arguments:      rate_hz - samples per second
+//
+//  Returns:        void
+//
+//  Description:    Sizes the buckets to cover the code and sets up
+//                  the ARM timer to interrupt rate_hz times a second. The
+//                  caller routes that interrupt (ARM basic IRQ 0) to FIQ
+//                  with fiq_register() and calls profile_sample() from the
+//                  handler. The timer is left stopped; call
+//                  profile_start(). Pick a rate
+//                  that is not a multiple of any periodic work being
+//                  profiled, or the samples will alias with it.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void profile_init(unsigned int rate_hz)
+{
+    unsigned long size;
+
+    if (_etext)
+        size = (unsigned long)_etext - PROFILE_BASE;
+    else
+        size = (unsigned long)_end - PROFILE_BASE;
+
+    shift = 2;
+    while ((size >> shift) >= PROFILE_BUCKETS)
+        shift++;
+
+    profile_reset();
+
+    period_us = ARM_TIMER_TICK_HZ / rate_hz;
+    *ARM_TIMER_CONTROL = 0;
+    *ARM_TIMER_PREDIV = ARM_TIMER_CLOCK / ARM_TIMER_TICK_HZ - 1;
+    *ARM_TIMER_LOAD = period_us - 1;
+    *ARM_TIMER_RELOAD = period_us - 1;
+    *ARM_TIMER_IRQ_CLR = 1;
+}
+
+
+// Start or resume sampling
+void profile_start(void)
+{
+    if (running)
+        return;
+
+    running = 1;
+    started = *SYSTIMER_CLO;
+    *ARM_TIMER_LOAD = period_us - 1;
+    *ARM_TIMER_CONTROL = ARM_TIMER_32BIT | ARM_TIMER_IRQ_EN | ARM_TIMER_ENABLE;
+}
+
+// Pause sampling, keeping the histogram
+void profile_stop(void)
+{
+    if (!running)
+        return;
+
+    *ARM_TIMER_CONTROL = 0;
+    *ARM_TIMER_IRQ_CLR = 1;
+    elapsed += *SYSTIMER_CLO - started;
+    running = 0;
+}
+
+// Empty the histogram. Only call while sampling is stopped.
+void profile_reset(void)
+{
+    unsigned int i;
+
+    for (i = 0; i < PROFILE_BUCKETS; i++)
+        buckets[i] = 0;
+    samples = 0;
+    outside = 0;
+    elapsed = 0;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_sample
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    ARM timer FIQ handler. ELR_EL1 still holds the address
+//                  the FIQ returns to, which may be inside an IRQ handler,
+//                  so it is read directly.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+IRQ_CODE void profile_sample(void)
+{
+    unsigned long elr;
+    unsigned long offset;
+
+    *ARM_TIMER_IRQ_CLR = 1;
+
+    asm volatile("mrs %0, elr_el1" : "=r"(elr));
+    offset = (elr - PROFILE_BASE) >> shift;
+
+    if (offset < PROFILE_BUCKETS)
+        buckets[offset]++;
+    else
+        outside++;
+    samples++;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       profile_dump
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Prints the histogram for tools/profsym.py, pausing
+//                  sampling so the dump itself is not profiled:
+//
+//                    profile: base 00080000 shift 2 samples N outside N time N
+//                    00080A40 N
+//                    ...
+//                    profile: end
+//
+//                  Each line between the two is a bucket start address and
+//                  its sample count; empty buckets are left out. time is the
+//                  sampling time in microseconds.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void profile_dump(void)
+{
+    unsigned int was_running = running;
+    unsigned int i;
+
+    profile_stop();
+
+    uart_puts("profile: base ");
+    uart_puthex(PROFILE_BASE);
+    uart_puts(" shift ");
+    console_putdec(shift);
+    uart_puts(" samples ");
+    console_putdec(samples);
+    uart_puts(" outside ");
+    console_putdec(outside);
+    uart_puts(" time ");
+    console_putdec(elapsed);
+    uart_puts("\n");
+
+    for (i = 0; i < PROFILE_BUCKETS; i++) {
+        if (buckets[i] == 0)
+            continue;
+        uart_puthex(PROFILE_BASE + (i << shift));
+        uart_puts(" ");
+        console_putdec(buckets[i]);
+        uart_puts("\n");
+    }
+    uart_puts("profile: end\n");
+
+    if (was_running)
+        profile_start();
+}
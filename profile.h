@@ -0,0 +1,32 @@
+// Statistical PC-sampling profiler. The ARM timer (SP804), which nothing
+// else uses, raises an FIQ at a fixed rate and the handler adds the
+// interrupted address (ELR_EL1) to a histogram of the kernel image in
+// fixed-size address buckets. profile_dump() prints the non-empty buckets
+// on the UART; tools/profsym.py turns a captured dump into a flat profile
+// per function using the ELF the image was built from.
+//
+// FIQs preempt code that only masks IRQs (pool_free()) and, with
+// IRQVEC_NESTED_FIQ (irqvec.h, on by default), IRQ handlers, so those are
+// sampled like everything else. Only the few instructions of the IRQ entry
+// and exit that run with FIQs masked are not; their time is charged to the
+// first instruction after FIQs are unmasked again.
+
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Start of the kernel image, the address of bucket 0
+#define PROFILE_BASE            0x80000
+
+// Number of histogram buckets. The bucket size is the smallest power of
+// two, at least one instruction, that spreads .text (up to _etext) over
+// them: one instruction per bucket for code up to 16 KiB.
+#define PROFILE_BUCKETS         4096
+
+void profile_init(unsigned int rate_hz);
+void profile_start(void);
+void profile_stop(void);
+void profile_reset(void);
+void profile_sample(void);
+void profile_dump(void);
+
+#endif
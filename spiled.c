@@ -0,0 +1,322 @@
+
+// Header files
+#include "gpio.h"
+#include "pin.h"
+#include "arena.h"
+#include "spiled.h"
+
+// SPI0 registers (p. 152 in the Broadcom manual)
+#define SPI0_CS         ((volatile unsigned int *)(MMIO_BASE + 0x00204000))
+#define SPI0_FIFO       ((volatile unsigned int *)(MMIO_BASE + 0x00204004))
+#define SPI0_CLK        ((volatile unsigned int *)(MMIO_BASE + 0x00204008))
+#define SPI0_DLEN       ((volatile unsigned int *)(MMIO_BASE + 0x0020400C))
+
+#define SPI0_CS_CLEAR_TX    (0x1 << 4)
+#define SPI0_CS_CLEAR_RX    (0x1 << 5)
+#define SPI0_CS_TA          (0x1 << 7)
+#define SPI0_CS_DMAEN       (0x1 << 8)
+#define SPI0_CS_ADCS        (0x1 << 11)
+
+// DMA controller (p. 39 in the Broadcom manual). Channels 4 and 5 are not
+// used by the VideoCore firmware.
+#define DMA_TX_CHANNEL  4
+#define DMA_RX_CHANNEL  5
+#define DMA_CS(ch)      ((volatile unsigned int *)(MMIO_BASE + 0x00007000 + (ch) * 0x100))
+#define DMA_CONBLK(ch)  ((volatile unsigned int *)(MMIO_BASE + 0x00007004 + (ch) * 0x100))
+#define DMA_ENABLE      ((volatile unsigned int *)(MMIO_BASE + 0x00007FF0))
+
+#define DMA_CS_ACTIVE   (0x1 << 0)
+#define DMA_CS_END      (0x1 << 1)
+#define DMA_CS_RESET    (0x1u << 31)
+
+#define DMA_TI_WAIT_RESP    (0x1 << 3)
+#define DMA_TI_DEST_INC     (0x1 << 4)
+#define DMA_TI_DEST_DREQ    (0x1 << 6)
+#define DMA_TI_SRC_INC      (0x1 << 8)
+#define DMA_TI_SRC_DREQ     (0x1 << 10)
+#define DMA_TI_PERMAP(p)    ((p) << 16)
+
+// DREQ lines of SPI0
+#define DREQ_SPI_TX     6
+#define DREQ_SPI_RX     7
+
+// The DMA engine sees SDRAM through the uncached bus alias and the
+// peripherals at 0x7E000000
+#define BUS_ADDR(p)     ((unsigned int)(unsigned long)(p) | 0xC0000000)
+#define SPI0_FIFO_BUS   0x7E204004
+
+// DMA control block; must be 32-byte aligned
+struct dma_cb {
+    unsigned int ti;
+    unsigned int source_ad;
+    unsigned int dest_ad;
+    unsigned int txfr_len;
+    unsigned int stride;
+    unsigned int nextconbk;
+    unsigned int reserved[2];
+};
+
+#define SPILED_PINS(X, a)                                                      \
+    X(a, SPILED_CE0_PIN, PIN_ALT0, PIN_PULL_NONE, PIN_EDGE_NONE)               \
+    X(a, SPILED_MOSI_PIN, PIN_ALT0, PIN_PULL_NONE, PIN_EDGE_NONE)              \
+    X(a, SPILED_SCLK_PIN, PIN_ALT0, PIN_PULL_NONE, PIN_EDGE_NONE)
+
+// Chain description
+static unsigned int led_type;
+static unsigned int led_count;
+static unsigned int data_bytes;     // bytes shifted out per frame
+static unsigned int frame_words;    // header word + data, in words
+
+// Set once spiled_init() has succeeded. Until then there are no frames,
+// and every other call does nothing.
+static unsigned int ready;
+
+// Double-buffered frames. Word 0 of each is the SPI DMA header, the LED
+// data follows. The back frame is drawn into while the front frame is
+// being sent.
+static unsigned int *frame[2];
+static unsigned int back;
+
+// DMA control blocks and the sink for the bytes clocked in on MISO
+static struct dma_cb *tx_cb;
+static struct dma_cb *rx_cb;
+static unsigned int *rx_sink;
+
+
+// Start of the LED data in a frame, after the header word
+static unsigned char *frame_data(unsigned int *f)
+{
+    return (unsigned char *)(f + 1);
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       spiled_init
+//
+//  Arguments:      type - SPILED_SHIFT_REGISTER or SPILED_APA102
+//                  count - number of LEDs in the chain
+//                  clock_div - SPI clock divider (core clock / clock_div)
+//
+//  Returns:        1 on success, 0 if the arena could not hold the frames
+//
+//  Description:    Allocates both frames and the DMA control blocks from
+//                  the arena, switches GPIO 8, 10, and 11 to SPI0, and
+//                  enables the two DMA channels. All LEDs start off. On
+//                  failure the other functions stay no-ops.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int spiled_init(unsigned int type, unsigned int count, unsigned int clock_div)
+{
+    ready = 0;
+    led_type = type;
+    led_count = count;
+
+    // Shift registers take one bit per LED. APA102 takes a 32-bit start
+    // frame, 32 bits per LED, and at least count/2 extra clocks at the end.
+    if (type == SPILED_APA102)
+        data_bytes = 4 + count * 4 + count / 16 + 1;
+    else
+        data_bytes = (count + 7) / 8;
+
+    // DMA moves whole words, so pad the data to a multiple of 4 bytes
+    data_bytes = (data_bytes + 3) & ~3u;
+    frame_words = 1 + data_bytes / 4;
+
+    frame[0] = arena_alloc(frame_words * 4, CACHE_LINE_SIZE);
+    frame[1] = arena_alloc(frame_words * 4, CACHE_LINE_SIZE);
+    tx_cb = arena_alloc(sizeof(struct dma_cb), 32);
+    rx_cb = arena_alloc(sizeof(struct dma_cb), 32);
+    rx_sink = arena_alloc(4, 4);
+    if (!frame[0] || !frame[1] || !tx_cb || !rx_cb || !rx_sink)
+        return 0;
+
+    back = 0;
+    ready = 1;
+    spiled_clear();
+
+    // Route SPI0 to the header pins and set the clock
+    pin_group_init(SPILED_PINS);
+    *SPI0_CS = SPI0_CS_CLEAR_TX | SPI0_CS_CLEAR_RX;
+    *SPI0_CLK = clock_div;
+
+    // Enable and reset the DMA channels
+    *DMA_ENABLE |= (0x1 << DMA_TX_CHANNEL) | (0x1 << DMA_RX_CHANNEL);
+    *DMA_CS(DMA_TX_CHANNEL) = DMA_CS_RESET;
+    *DMA_CS(DMA_RX_CHANNEL) = DMA_CS_RESET;
+
+    return 1;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       spiled_clear
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Turns every LED off in the back frame.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void spiled_clear(void)
+{
+    unsigned int *f = frame[back];
+    unsigned char *d;
+    unsigned int i;
+
+    if (!ready)
+        return;
+
+    for (i = 1; i < frame_words; i++)
+        f[i] = 0;
+
+    // APA102 LED frames start with 0b111 and the brightness
+    if (led_type == SPILED_APA102) {
+        d = frame_data(f);
+        for (i = 0; i < led_count; i++)
+            d[4 + i * 4] = 0xE0 | 0x1F;
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       spiled_set
+//
+//  Arguments:      index - LED number, 0 being the one nearest the Pi
+//                  rgb - colour as 0xRRGGBB; shift registers treat any
+//                        nonzero value as on
+//
+//  Returns:        void
+//
+//  Description:    Changes one LED in the back frame. Nothing is sent until
+//                  spiled_show() is called.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void spiled_set(unsigned int index, unsigned int rgb)
+{
+    unsigned char *d;
+    unsigned int byte;
+
+    if (!ready || index >= led_count)
+        return;
+
+    d = frame_data(frame[back]);
+
+    if (led_type == SPILED_APA102) {
+        d += 4 + index * 4;
+        d[1] = rgb & 0xFF;              // blue
+        d[2] = (rgb >> 8) & 0xFF;       // green
+        d[3] = (rgb >> 16) & 0xFF;      // red
+    } else {
+        // The first byte shifted out ends up furthest down the chain, so
+        // the nearest register's byte goes out last. Padding bytes at the
+        // start of the frame fall off the end of the chain.
+        byte = data_bytes - 1 - index / 8;
+        if (rgb)
+            d[byte] |= 0x1 << (index % 8);
+        else
+            d[byte] &= ~(0x1 << (index % 8));
+    }
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       spiled_busy
+//
+//  Arguments:      none
+//
+//  Returns:        nonzero while a frame is still being sent
+//
+//  Description:    Lets the caller skip a refresh rather than wait.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+int spiled_busy(void)
+{
+    if (!ready)
+        return 0;
+
+    return (*DMA_CS(DMA_TX_CHANNEL) | *DMA_CS(DMA_RX_CHANNEL)) & DMA_CS_ACTIVE;
+}
+
+
+
+////////////////////////////////////////////////////////////////////////////////
+//
+//  Function:       spiled_show
+//
+//  Arguments:      none
+//
+//  Returns:        void
+//
+//  Description:    Sends the back frame to the LEDs. The buffers are
+//                  swapped and the new front frame is handed to two DMA
+//                  channels: one feeds the SPI TX FIFO (the first word sets
+//                  the transfer length and starts the transfer), the other
+//                  drains the RX FIFO so the transfer does not stall. The
+//                  new back frame starts as a copy of what is being shown.
+//
+////////////////////////////////////////////////////////////////////////////////
+
+void spiled_show(void)
+{
+    unsigned int *f;
+    unsigned int i;
+
+    if (!ready)
+        return;
+
+    // Wait for the previous frame to finish
+    while (spiled_busy()) {
+        asm volatile("nop");
+    }
+
+    f = frame[back];
+    back ^= 1;
+    for (i = 1; i < frame_words; i++)
+        frame[back][i] = f[i];
+
+    // In DMA mode the first word written to the FIFO is the byte count
+    // and the low byte of SPI0_CS (chip select 0, transfer active)
+    f[0] = (data_bytes << 16) | SPI0_CS_TA;
+
+    rx_cb->ti = DMA_TI_PERMAP(DREQ_SPI_RX) | DMA_TI_SRC_DREQ | DMA_TI_WAIT_RESP;
+    rx_cb->source_ad = SPI0_FIFO_BUS;
+    rx_cb->dest_ad = BUS_ADDR(rx_sink);
+    rx_cb->txfr_len = data_bytes;
+    rx_cb->stride = 0;
+    rx_cb->nextconbk = 0;
+
+    tx_cb->ti = DMA_TI_PERMAP(DREQ_SPI_TX) | DMA_TI_DEST_DREQ | DMA_TI_SRC_INC |
+                DMA_TI_WAIT_RESP;
+    tx_cb->source_ad = BUS_ADDR(f);
+    tx_cb->dest_ad = SPI0_FIFO_BUS;
+    tx_cb->txfr_len = frame_words * 4;
+    tx_cb->stride = 0;
+    tx_cb->nextconbk = 0;
+
+    // Make the frame and control blocks visible before the DMA reads them
+    asm volatile("dsb sy" ::: "memory");
+
+    *SPI0_CS = SPI0_CS_CLEAR_TX | SPI0_CS_CLEAR_RX | SPI0_CS_DMAEN | SPI0_CS_ADCS;
+
+    // Start the RX side first so no received byte is missed
+    *DMA_CS(DMA_RX_CHANNEL) = DMA_CS_END;
+    *DMA_CONBLK(DMA_RX_CHANNEL) = BUS_ADDR(rx_cb);
+    *DMA_CS(DMA_RX_CHANNEL) = DMA_CS_ACTIVE;
+
+    *DMA_CS(DMA_TX_CHANNEL) = DMA_CS_END;
+    *DMA_CONBLK(DMA_TX_CHANNEL) = BUS_ADDR(tx_cb);
+    *DMA_CS(DMA_TX_CHANNEL) = DMA_CS_ACTIVE;
+}
@@ -0,0 +1,32 @@
+// LED expansion through SPI0. The LED state is kept in a frame buffer in
+// RAM; spiled_show() hands the whole frame to the SPI controller with one
+// DMA transfer, so refreshing any number of LEDs costs a few register
+// writes instead of one GPSET/GPCLR write per LED.
+//
+// Two kinds of chain are supported:
+//   SPILED_SHIFT_REGISTER - daisy-chained 74HC595s, one bit per LED. MOSI
+//                           to SER, SCLK to SRCLK, CE0 to RCLK (the chip
+//                           select going high at the end of the frame
+//                           latches the outputs).
+//   SPILED_APA102         - APA102/SK9822 addressable strips, 24-bit colour
+//                           per LED. MOSI to DI, SCLK to CI.
+
+#ifndef SPILED_H
+#define SPILED_H
+
+// Chain types
+#define SPILED_SHIFT_REGISTER   0
+#define SPILED_APA102           1
+
+// SPI0 pins (ALT0)
+#define SPILED_CE0_PIN          8
+#define SPILED_MOSI_PIN         10
+#define SPILED_SCLK_PIN         11
+
+int spiled_init(unsigned int type, unsigned int count, unsigned int clock_div);
+void spiled_clear(void);
+void spiled_set(unsigned int index, unsigned int rgb);
+int spiled_busy(void);
+void spiled_show(void);
+
+#endif
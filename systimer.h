@@ -0,0 +1,25 @@
+// BCM2837 System Timer registers. The free-running counter ticks at 1 MHz,
+// so CLO can be read directly as a microsecond timestamp. Compare channels
+// 0 and 2 are used by the VideoCore; channels 1 and 3 are free for the ARM.
+// See p. 172 in the Broadcom Peripherals Manual.
+
+#ifndef SYSTIMER_H
+#define SYSTIMER_H
+
+#ifndef MMIO_BASE
+#define MMIO_BASE       0x3F000000
+#endif
+
+#define SYSTIMER_CS     ((volatile unsigned int *)(MMIO_BASE + 0x00003000))
+#define SYSTIMER_CLO    ((volatile unsigned int *)(MMIO_BASE + 0x00003004))
+#define SYSTIMER_CHI    ((volatile unsigned int *)(MMIO_BASE + 0x00003008))
+#define SYSTIMER_C0     ((volatile unsigned int *)(MMIO_BASE + 0x0000300C))
+#define SYSTIMER_C1     ((volatile unsigned int *)(MMIO_BASE + 0x00003010))
+#define SYSTIMER_C2     ((volatile unsigned int *)(MMIO_BASE + 0x00003014))
+#define SYSTIMER_C3     ((volatile unsigned int *)(MMIO_BASE + 0x00003018))
+
+// Match flags in SYSTIMER_CS (write 1 to clear)
+#define SYSTIMER_CS_M1  (0x1 << 1)
+#define SYSTIMER_CS_M3  (0x1 << 3)
+
+#endif
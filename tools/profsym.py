@@ -0,0 +1,154 @@
+#!/usr/bin/env python3
+"""Symbolize a profile dump (profile.c) into a flat profile.
+
+Capture the UART output while the firmware runs, trigger a dump (A+B
+chord or the # key), then point this tool at the capture and the ELF the
+image was built from. Each address bucket is charged to the function
+containing its start address. Buckets are one instruction wide while
+.text fits in 16 KiB, and only a few wide beyond that (the dump header
+gives the width), so few buckets straddle a function boundary.
+
+Examples:
+    tools/sendimg.py kernel8.img /dev/ttyUSB0 | tee uart.log
+    tools/profsym.py kernel8.elf uart.log
+    tools/profsym.py kernel8.elf uart.log --lines 20
+
+Uses nm and addr2line from the cross toolchain (found automatically, or
+given with --cross) and only the Python standard library.
+"""
+
+import argparse
+import bisect
+import re
+import shutil
+import subprocess
+import sys
+
+CROSS_PREFIXES = ["aarch64-none-elf-", "aarch64-elf-", "aarch64-linux-gnu-", ""]
+
+HEADER = re.compile(r"profile: base ([0-9A-Fa-f]+) shift (\d+) samples (\d+)"
+                    r" outside (\d+) time (\d+)")
+BUCKET = re.compile(r"^([0-9A-Fa-f]{8}) (\d+)$")
+END = "profile: end"
+
+
+def find_tool(cross, name):
+    prefixes = [cross] if cross is not None else CROSS_PREFIXES
+    for prefix in prefixes:
+        path = shutil.which(prefix + name)
+        if path:
+            return path
+    sys.exit("cannot find %s; use --cross to give the toolchain prefix" % name)
+
+
+def read_dumps(lines):
+    """Yield (header, {address: count}) for each complete dump."""
+    header = None
+    buckets = {}
+    for line in lines:
+        line = line.strip()
+        m = HEADER.search(line)
+        if m:
+            header = dict(zip(("base", "shift", "samples", "outside", "time"),
+                              (int(m.group(1), 16),) +
+                              tuple(int(g) for g in m.group(2, 3, 4, 5))))
+            buckets = {}
+        elif header and line.endswith(END):
+            yield header, buckets
+            header = None
+        elif header:
+            m = BUCKET.match(line)
+            if m:
+                addr = int(m.group(1), 16)
+                buckets[addr] = buckets.get(addr, 0) + int(m.group(2))
+
+
+def load_symbols(nm, elf):
+    """Sorted (address, name) list of the code symbols in the ELF."""
+    out = subprocess.run([nm, "-n", "--defined-only", elf], check=True,
+                         capture_output=True, text=True).stdout
+    symbols = []
+    for line in out.splitlines():
+        fields = line.split()
+        if len(fields) == 3 and fields[1] in "tTwW":
+            symbols.append((int(fields[0], 16), fields[2]))
+    return symbols
+
+
+def source_lines(addr2line, elf, addrs):
+    out = subprocess.run([addr2line, "-f", "-C", "-e", elf] +
+                         ["%x" % a for a in addrs], check=True,
+                         capture_output=True, text=True).stdout.splitlines()
+    return [(out[i], out[i + 1]) for i in range(0, len(out) - 1, 2)]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf", help="ELF file the running image came from")
+    parser.add_argument("log", nargs="?", help="captured UART output"
+                        " (default: standard input)")
+    parser.add_argument("--all", action="store_true",
+                        help="sum every dump in the log, not just the last")
+    parser.add_argument("--lines", type=int, metavar="N", default=0,
+                        help="also list the N busiest buckets by source line")
+    parser.add_argument("--cross", metavar="PREFIX",
+                        help="toolchain prefix, e.g. aarch64-none-elf-")
+    args = parser.parse_args()
+
+    if args.log:
+        with open(args.log, errors="replace") as f:
+            dumps = list(read_dumps(f))
+    else:
+        dumps = list(read_dumps(sys.stdin))
+    if not dumps:
+        sys.exit("no complete profile dump found")
+    if not args.all:
+        dumps = dumps[-1:]
+
+    samples = outside = time_us = 0
+    buckets = {}
+    for header, dump in dumps:
+        samples += header["samples"]
+        outside += header["outside"]
+        time_us += header["time"]
+        for addr, count in dump.items():
+            buckets[addr] = buckets.get(addr, 0) + count
+    if not samples:
+        sys.exit("the dump holds no samples")
+
+    symbols = load_symbols(find_tool(args.cross, "nm"), args.elf)
+    starts = [addr for addr, _ in symbols]
+
+    functions = {}
+    for addr, count in buckets.items():
+        i = bisect.bisect_right(starts, addr) - 1
+        name = symbols[i][1] if i >= 0 else "[unknown]"
+        functions[name] = functions.get(name, 0) + count
+    if outside:
+        functions["[outside image]"] = outside
+
+    rate = samples / (time_us / 1e6) if time_us else 0
+    print("%d samples over %.3f s (%.0f Hz), %d dump(s)"
+          % (samples, time_us / 1e6, rate, len(dumps)))
+    print()
+    print("%7s %7s %9s  %s" % ("self%", "cum%", "samples", "function"))
+    cumulative = 0
+    for name, count in sorted(functions.items(), key=lambda f: -f[1]):
+        cumulative += count
+        print("%6.2f%% %6.2f%% %9d  %s" % (100.0 * count / samples,
+                                            100.0 * cumulative / samples,
+                                            count, name))
+
+    if args.lines:
+        top = sorted(buckets.items(), key=lambda b: -b[1])[:args.lines]
+        where = source_lines(find_tool(args.cross, "addr2line"), args.elf,
+                             [addr for addr, _ in top])
+        print()
+        print("%7s %9s  %-8s  %s" % ("self%", "samples", "address", "source"))
+        for (addr, count), (func, line) in zip(top, where):
+            print("%6.2f%% %9d  %08x  %s (%s)"
+                  % (100.0 * count / samples, count, addr, line, func))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,236 @@
+#!/usr/bin/env python3
+"""Send a kernel image to the serial chainloader (chainloader.c).
+
+The image is LZ4-compressed (block format) and sent with a CRC-32 of the
+uncompressed data. The loader decompresses it straight into the load
+address and jumps to it. The tool reports image size, compressed size,
+transfer time, and the time from the jump to the first byte the new image
+prints, then passes the board's output through to the terminal.
+
+Examples:
+    tools/sendimg.py kernel8.img /dev/ttyUSB0
+    # QEMU (waits for the tool to connect before starting the guest):
+    # qemu-system-aarch64 -M raspi3b -kernel chainloader.img \
+    #           -serial null -serial tcp::5555,server
+    tools/sendimg.py kernel8.img tcp:localhost:5555
+
+Only the Python standard library is needed. If the lz4 package is
+installed its compressor is used, since it compresses better than the
+built-in one.
+"""
+
+import argparse
+import os
+import select
+import socket
+import struct
+import sys
+import termios
+import time
+import tty
+import zlib
+
+MAGIC = b"C359"
+READY = b"\x03\x03\x03"
+LOAD_ADDR = 0x80000
+
+# Failure replies from the loader
+ERRORS = {
+    b"HE": "header corrupted in transit",
+    b"SE": "image does not fit below the loader",
+    b"CE": "CRC mismatch after loading",
+    b"DE": "corrupt LZ4 data",
+    b"TO": "transfer stalled",
+}
+
+
+def lz4_compress_simple(data):
+    """Greedy single-probe LZ4 block compressor."""
+    n = len(data)
+    out = bytearray()
+    table = {}
+    anchor = 0
+    i = 0
+    # The last match must start at least 12 bytes before the end and the
+    # last 5 bytes must be literals.
+    mflimit = n - 12
+
+    def put_len(length):
+        while length >= 255:
+            out.append(255)
+            length -= 255
+        out.append(length)
+
+    def put_sequence(lit_end, offset, mlen):
+        lit = lit_end - anchor
+        token = (min(lit, 15) << 4) | (min(mlen - 4, 15) if mlen else 0)
+        out.append(token)
+        if lit >= 15:
+            put_len(lit - 15)
+        out.extend(data[anchor:lit_end])
+        if mlen:
+            out.extend(struct.pack("<H", offset))
+            if mlen - 4 >= 15:
+                put_len(mlen - 4 - 15)
+
+    while i < mflimit:
+        key = data[i:i + 4]
+        cand = table.get(key)
+        table[key] = i
+        if cand is not None and i - cand <= 0xFFFF:
+            m = 4
+            while i + m < n - 5 and data[cand + m] == data[i + m]:
+                m += 1
+            put_sequence(i, i - cand, m)
+            i += m
+            anchor = i
+        else:
+            i += 1
+
+    put_sequence(n, 0, 0)
+    return bytes(out)
+
+
+def lz4_compress(data):
+    try:
+        import lz4.block
+        return lz4.block.compress(data, mode="high_compression",
+                                  store_size=False)
+    except ImportError:
+        return lz4_compress_simple(data)
+
+
+class Port:
+    """A serial device or a TCP socket (for QEMU's -serial tcp:...)."""
+
+    def __init__(self, target, baud):
+        self.sock = None
+        self.fd = None
+        self.pending = b""
+        if target.startswith("tcp:"):
+            host, port = target[4:].rsplit(":", 1)
+            self.sock = socket.create_connection((host, int(port)))
+        else:
+            self.fd = os.open(target, os.O_RDWR | os.O_NOCTTY)
+            tty.setraw(self.fd)
+            attrs = termios.tcgetattr(self.fd)
+            speed = getattr(termios, "B%d" % baud)
+            attrs[4] = attrs[5] = speed
+            termios.tcsetattr(self.fd, termios.TCSANOW, attrs)
+
+    def fileno(self):
+        return self.sock.fileno() if self.sock else self.fd
+
+    def write(self, data):
+        if self.sock:
+            self.sock.sendall(data)
+        else:
+            while data:
+                data = data[os.write(self.fd, data):]
+
+    def read(self, timeout=None):
+        if self.pending:
+            data, self.pending = self.pending, b""
+            return data
+        ready, _, _ = select.select([self], [], [], timeout)
+        if not ready:
+            return b""
+        if self.sock:
+            return self.sock.recv(4096)
+        return os.read(self.fd, 4096)
+
+    def read_exact(self, count, timeout, skip=b""):
+        """Read count bytes, dropping any leading bytes found in skip.
+        Anything read beyond them is kept for the next read."""
+        data = b""
+        deadline = time.monotonic() + timeout
+        while len(data) < count:
+            chunk = self.read(max(0, deadline - time.monotonic()))
+            if not chunk:
+                sys.exit("no reply from the chainloader")
+            data += chunk
+            if not data.strip(skip):
+                data = b""
+            else:
+                data = data.lstrip(skip)
+        self.pending = data[count:] + self.pending
+        return data[:count]
+
+    def read_status(self, timeout):
+        """Read a two-byte reply, skipping repeated ready signals."""
+        return self.read_exact(2, timeout, skip=READY[:1])
+
+
+def wait_for_ready(port):
+    print("waiting for the chainloader (reset the board)...", file=sys.stderr)
+    seen = b""
+    while READY not in seen:
+        chunk = port.read()
+        # Pass through anything the board prints, but not the (repeated)
+        # ready signal itself
+        sys.stdout.buffer.write(chunk.replace(READY[:1], b""))
+        sys.stdout.flush()
+        seen = (seen + chunk)[-16:]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image", help="kernel image, e.g. kernel8.img")
+    parser.add_argument("target", help="serial device or tcp:HOST:PORT")
+    parser.add_argument("--baud", type=int, default=115200)
+    parser.add_argument("--raw", action="store_true",
+                        help="send uncompressed")
+    args = parser.parse_args()
+
+    with open(args.image, "rb") as f:
+        image = f.read()
+    payload = image if args.raw else lz4_compress(image)
+    if len(payload) >= len(image):
+        payload = image
+    compressed = 0 if payload is image else len(payload)
+
+    print("image: %d bytes, sending %d bytes (%.1f%%)"
+          % (len(image), len(payload), 100.0 * len(payload) / len(image)),
+          file=sys.stderr)
+
+    port = Port(args.target, args.baud)
+    wait_for_ready(port)
+
+    start = time.monotonic()
+    header = struct.pack("<IIII", LOAD_ADDR, len(image), compressed,
+                         zlib.crc32(image))
+    port.write(MAGIC + header + struct.pack("<I", zlib.crc32(header)))
+    status = port.read_status(5)
+    if status != b"OK":
+        sys.exit("chainloader refused the header: %s"
+                 % ERRORS.get(status, repr(status)))
+
+    port.write(payload)
+    status = port.read_status(60)
+    if status != b"OK":
+        sys.exit("chainloader reported: %s" % ERRORS.get(status, repr(status)))
+    rx_us, unpack_us = struct.unpack("<II", port.read_exact(8, 5))
+    sent = time.monotonic()
+
+    print("transfer: %.3f s (loader: receive %.3f s, decompress %.3f s)"
+          % (sent - start, rx_us / 1e6, unpack_us / 1e6), file=sys.stderr)
+
+    # The first byte after the reply comes from the new image (it may
+    # already have arrived with the reply)
+    first = port.read()
+    booted = time.monotonic()
+    print("boot: first output %.3f s after the jump, %.3f s total"
+          % (booted - sent, booted - start), file=sys.stderr)
+
+    out = sys.stdout.buffer
+    while first:
+        out.write(first)
+        out.flush()
+        first = port.read()
+
+
+if __name__ == "__main__":
+    try:
+        main()
+    except KeyboardInterrupt:
+        pass